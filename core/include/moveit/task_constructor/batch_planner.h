@@ -0,0 +1,89 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2026, MoveIt Task Constructor contributors
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of the copyright holder nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+/* Plan multiple tasks concurrently on a shared thread pool */
+
+#pragma once
+
+#include <cstddef>
+#include <functional>
+#include <future>
+#include <memory>
+#include <thread>
+
+namespace moveit {
+namespace task_constructor {
+
+class Task;
+class BatchPlannerPrivate;
+
+/** BatchPlanner plans many independent tasks concurrently, using a shared pool of worker threads.
+ *
+ * Tasks are planned interleaved, one top-level compute() iteration at a time.
+ * Workers pick the task with least accumulated compute time, weighted by the task's priority:
+ * a task with twice the priority of another one receives about twice as much compute time.
+ * Planning pipelines are shared between tasks anyway (see Task::createPlanner()).
+ *
+ * Tasks must remain valid until their planning finished and must not be planned otherwise meanwhile.
+ */
+class BatchPlanner
+{
+public:
+	/// called from a worker thread when a task finished planning
+	using DoneCallback = std::function<void(Task& task, bool success)>;
+
+	explicit BatchPlanner(size_t num_threads = std::thread::hardware_concurrency());
+	BatchPlanner(const BatchPlanner& other) = delete;
+	/// preempts all pending tasks and waits for the workers to finish
+	~BatchPlanner();
+
+	/** schedule planning of task, with arguments as for Task::plan()
+	 *
+	 * The returned future yields the result of planning or the exception raised by it.
+	 */
+	std::future<bool> add(Task& task, size_t max_solutions = 0, double timeout = 0.0, double priority = 1.0,
+	                      const DoneCallback& done = DoneCallback());
+
+	/// number of tasks not yet finished
+	size_t numPending() const;
+	/// block until all tasks are finished
+	void wait();
+	/// interrupt planning of all pending tasks
+	void preempt();
+
+private:
+	std::unique_ptr<BatchPlannerPrivate> impl_;
+};
+}  // namespace task_constructor
+}  // namespace moveit
@@ -0,0 +1,74 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2026, MoveIt Task Constructor contributors
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of the copyright holder nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+/* Cooperative cancellation of long-running computations */
+
+#pragma once
+
+#include <atomic>
+
+namespace moveit {
+namespace task_constructor {
+namespace cancellation {
+
+/// flag polled by requested() in the calling thread (or nullptr)
+const std::atomic<bool>* current();
+
+/** Was the computation running in the calling thread cancelled?
+ *
+ * While planning, a Task installs its preemption flag for the computing thread.
+ * Long-running loops (planners, IK sampling, validity callbacks) should poll this
+ * and return early, such that Task::preempt() takes effect quickly.
+ * Polling costs a thread-local lookup and an atomic load.
+ */
+inline bool requested() {
+	const std::atomic<bool>* flag = current();
+	return flag && flag->load(std::memory_order_relaxed);
+}
+
+/// install the given flag (may be nullptr) for the calling thread, restoring the previous one on destruction
+class Scope
+{
+public:
+	explicit Scope(const std::atomic<bool>* flag);
+	~Scope();
+	Scope(const Scope&) = delete;
+	Scope& operator=(const Scope&) = delete;
+
+private:
+	const std::atomic<bool>* previous_;
+};
+}  // namespace cancellation
+}  // namespace task_constructor
+}  // namespace moveit
@@ -40,9 +40,61 @@
 
 #include "stage.h"
 
+#include <vector>
+
 namespace moveit {
 namespace task_constructor {
 
+MOVEIT_CLASS_FORWARD(SchedulingPolicy)
+/** Strategy to choose the child of a container to compute next
+ *
+ * By default, containers compute all their children ready to compute in turn.
+ * If a scheduling policy is configured, a single child selected by the policy is computed instead.
+ * Policies are considered by SerialContainer and Alternatives only: Fallbacks inherently compute
+ * their children one after the other and Merger needs all of its children to compute.
+ */
+class SchedulingPolicy
+{
+public:
+	virtual ~SchedulingPolicy() = default;
+
+	/// reset internal state (called on reset of the container)
+	virtual void reset() {}
+	/// select the child to compute next from the (non-empty) list of children ready to compute
+	virtual Stage* select(const std::vector<Stage*>& ready) = 0;
+};
+
+/// cycle through all children, giving each of them the same chance
+class RoundRobinScheduling : public SchedulingPolicy
+{
+public:
+	void reset() override { last_ = nullptr; }
+	Stage* select(const std::vector<Stage*>& ready) override;
+
+private:
+	const Stage* last_ = nullptr;
+};
+
+/** best-first: expand the child having the cheapest pending partial solution
+ *
+ * Generators are only chosen if no other child has pending states.
+ */
+class CostGuidedScheduling : public SchedulingPolicy
+{
+public:
+	Stage* select(const std::vector<Stage*>& ready) override;
+};
+
+/** expand the child whose pending partial solution is closest to a full solution
+ *
+ * Partial solutions spanning more stages are preferred, ties are broken by cost.
+ */
+class CompletionGuidedScheduling : public SchedulingPolicy
+{
+public:
+	Stage* select(const std::vector<Stage*>& ready) override;
+};
+
 class ContainerBasePrivate;
 /** Base class for all container stages, i.e. ones that have one or more children */
 class ContainerBase : public Stage
@@ -72,6 +124,11 @@ public:
 	void reset() override;
 	void init(const moveit::core::RobotModelConstPtr& robot_model) override;
 
+	/// configure policy to choose the next child to compute (nullptr to compute all children in turn)
+	/// Only SerialContainer and Alternatives consider the policy.
+	void setSchedulingPolicy(const SchedulingPolicyPtr& policy);
+	const SchedulingPolicyPtr& schedulingPolicy() const;
+
 	virtual bool canCompute() const = 0;
 	virtual void compute() = 0;
 
@@ -150,15 +207,29 @@ protected:
  *
  * Solution of all children are reported - sorted by cost.
  */
+class AlternativesPrivate;
 class Alternatives : public ParallelContainerBase
 {
 public:
-	Alternatives(const std::string& name = "alternatives") : ParallelContainerBase(name) {}
+	PRIVATE_CLASS(Alternatives)
+	Alternatives(const std::string& name = "alternatives");
+
+	/** Compute all children concurrently, each in its own thread
+	 *
+	 * Solutions found during a compute() call are lifted afterwards, sorted by cost,
+	 * yielding a deterministic order. Children need to be safe for concurrent computation,
+	 * e.g. not sharing non-thread-safe IK solvers. Ignored if a scheduling policy is set.
+	 */
+	void setConcurrent(bool concurrent);
+	bool concurrent() const;
 
 	bool canCompute() const override;
 	void compute() override;
 
 	void onNewSolution(const SolutionBase& s) override;
+
+protected:
+	Alternatives(AlternativesPrivate* impl);
 };
 
 /** Plan for different alternatives in sequence.
@@ -167,12 +238,21 @@ public:
  * proceed to the next child trying an alternative planning strategy.
  * All solutions of the last active child are reported.
  */
+class FallbacksPrivate;
 class Fallbacks : public ParallelContainerBase
 {
-	mutable Stage* active_child_ = nullptr;
-
 public:
-	Fallbacks(const std::string& name = "fallbacks") : ParallelContainerBase(name) {}
+	PRIVATE_CLASS(Fallbacks)
+	Fallbacks(const std::string& name = "fallbacks");
+
+	/** In speculative mode, the next fallback child already computes in a background thread
+	 *
+	 * Its solutions are held back until all higher-priority children are exhausted.
+	 * Thus a slow, failing primary strategy doesn't delay a working fallback anymore.
+	 * Children need to be safe for concurrent computation, e.g. not sharing non-thread-safe IK solvers.
+	 */
+	void setSpeculative(bool speculative);
+	bool speculative() const;
 
 	void reset() override;
 	void init(const moveit::core::RobotModelConstPtr& robot_model) override;
@@ -180,6 +260,9 @@ public:
 	void compute() override;
 
 	void onNewSolution(const SolutionBase& s) override;
+
+protected:
+	Fallbacks(FallbacksPrivate* impl);
 };
 
 class MergerPrivate;
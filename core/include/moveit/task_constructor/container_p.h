@@ -43,6 +43,7 @@
 #include "stage_p.h"
 
 #include <map>
+#include <mutex>
 #include <climits>
 
 namespace moveit {
@@ -112,6 +113,15 @@ public:
 	// forward these methods to the public interface for containers
 	bool canCompute() const override;
 	void compute() override;
+	// best pending priority of all children
+	InterfaceState::Priority pendingPriority() const override;
+	// prune children's states
+	void pruneStates(double bound) override;
+	void releaseSolutions(double bound, const std::set<const SolutionBase*>& keep) override;
+
+	/// choose the next child to compute via the scheduling policy, nullptr if no child is ready
+	Stage* selectChild() const;
+	inline const SchedulingPolicyPtr& schedulingPolicy() const { return scheduling_policy_; }
 
 	InterfacePtr pendingBackward() const { return pending_backward_; }
 	InterfacePtr pendingForward() const { return pending_forward_; }
@@ -145,6 +155,8 @@ protected:
 
 private:
 	container_type children_;
+	// policy to choose next child to compute
+	SchedulingPolicyPtr scheduling_policy_;
 
 	// map start/end states of children (internal) to corresponding states in our external interfaces
 	std::map<const InterfaceState*, InterfaceState*> internal_to_external_;
@@ -177,6 +189,13 @@ public:
 
 	void reset();
 
+	/** assign child a deadline, sharing the remaining time with subsequent children ready to compute
+	 *
+	 * Shares are proportional to the children's average compute time. Children without any solution
+	 * yet block all complete solutions and receive a larger share.
+	 */
+	void assignDeadline(container_type::const_iterator child);
+
 protected:
 	// connect two neighbors
 	void connect(StagePrivate& stage1, StagePrivate& stage2);
@@ -201,6 +220,7 @@ public:
 	  : SolutionBase(creator, cost), wrapped_(wrapped) {}
 	explicit WrappedSolution(StagePrivate* creator, const SolutionBase* wrapped)
 	  : WrappedSolution(creator, wrapped, wrapped->cost()) {}
+	const SolutionBase* wrapped() const { return wrapped_; }
 	void fillMessage(moveit_task_constructor_msgs::Solution& solution,
 	                 Introspection* introspection = nullptr) const override;
 
@@ -220,6 +240,14 @@ public:
 
 	void validateConnectivity() const override;
 
+	/** compute given children concurrently: the first one in the calling thread, all others in background threads
+	 *
+	 * Background children push their new states into private interfaces, which are moved into the
+	 * shared pending interfaces on the calling thread once all children finished.
+	 * Background threads observe cancellation of the calling thread.
+	 */
+	void computeConcurrently(const std::vector<Stage*>& children);
+
 protected:
 	void validateInterfaces(const StagePrivate& child, InterfaceFlags& external, bool first = false) const;
 
@@ -238,13 +266,60 @@ public:
 };
 PIMPL_FUNCTIONS(WrapperBase)
 
+class AlternativesPrivate : public ParallelContainerBasePrivate
+{
+	friend class Alternatives;
+
+public:
+	AlternativesPrivate(Alternatives* me, const std::string& name);
+
+private:
+	bool concurrent_ = false;
+	// while computing concurrently, children's solutions are collected here (per child) before lifting
+	bool collecting_ = false;
+	std::map<const StagePrivate*, std::vector<const SolutionBase*>> collected_;
+	std::mutex collected_mutex_;
+};
+PIMPL_FUNCTIONS(Alternatives)
+
+class FallbacksPrivate : public ParallelContainerBasePrivate
+{
+	friend class Fallbacks;
+
+public:
+	FallbacksPrivate(Fallbacks* me, const std::string& name);
+
+	/// advance active_child_ to the first child that can compute, releasing held back solutions on the way
+	void activateNext();
+	/// first child after active_child_ that can compute
+	Stage* speculativeChild() const;
+	bool hasHeldBack(const Stage* child) const;
+	/// lift solutions held back for child
+	void liftHeldBack(const Stage* child);
+
+private:
+	Stage* active_child_ = nullptr;
+	bool speculative_ = false;
+	// while computing concurrently, solutions of all children are held back
+	bool computing_concurrently_ = false;
+	// solutions of speculatively computed children, held back until these become active
+	std::map<const StagePrivate*, std::vector<const SolutionBase*>> held_back_;
+	mutable std::mutex held_back_mutex_;
+};
+PIMPL_FUNCTIONS(Fallbacks)
+
 class MergerPrivate : public ParallelContainerBasePrivate
 {
 	friend class Merger;
 
-	moveit::core::JointModelGroupPtr jmg_merged_;
+public:
 	using ChildSolutionList = std::vector<const SubTrajectory*>;
 	using ChildSolutionMap = std::map<const StagePrivate*, ChildSolutionList>;
+
+private:
+	moveit::core::JointModelGroupPtr jmg_merged_;
+	// previously merged groups, still referenced by merged trajectories
+	std::vector<moveit::core::JointModelGroupPtr> jmgs_merged_;
 	// map from external source state (iterator) to all corresponding children's solutions
 	std::map<InterfaceState*, ChildSolutionMap> source_state_to_solutions_;
 
@@ -256,9 +331,19 @@ public:
 
 	void onNewPropagateSolution(const SolutionBase& s);
 	void onNewGeneratorSolution(const SolutionBase& s);
+	/// merge current solution with combinations of other children's solutions, best (cheapest) first
 	void mergeAnyCombination(const ChildSolutionMap& all_solutions, const SolutionBase& current,
 	                         const planning_scene::PlanningSceneConstPtr& start_scene, const Spawner& spawner);
-	void merge(const ChildSolutionList& sub_solutions, const planning_scene::PlanningSceneConstPtr& start_scene,
+	/// enumerate up to max combinations (0: all) including current solution, sorted by summed cost
+	static std::vector<ChildSolutionList> bestCombinations(const ChildSolutionMap& all_solutions,
+	                                                       const SolutionBase& current, size_t max);
+	/// merge sub solutions into a valid trajectory (or nullptr), using (and possibly creating) merged group jmg
+	static robot_trajectory::RobotTrajectoryPtr merge(const ChildSolutionList& sub_solutions,
+	                                                  const planning_scene::PlanningSceneConstPtr& start_scene,
+	                                                  moveit::core::JointModelGroup*& jmg);
+	/// keep merged group alive and use it for future merges
+	void adoptMergedGroup(moveit::core::JointModelGroup* jmg);
+	void spawn(const ChildSolutionList& sub_solutions, const robot_trajectory::RobotTrajectoryPtr& merged,
 	           const Spawner& spawner);
 
 	void sendForward(SubTrajectory&& t, const InterfaceState* from);
@@ -87,6 +87,8 @@ public:
 
 	/// register the given solution, assigning a unique ID
 	void registerSolution(const SolutionBase& s);
+	/// forget about a solution that is going to be discarded
+	void releaseSolution(const SolutionBase& s);
 
 	/// publish the given solution
 	void publishSolution(const SolutionBase& s);
@@ -54,9 +54,10 @@ moveit::core::JointModelGroup* merge(const std::vector<const moveit::core::Joint
  * (to know about the involved joint names), a merged JointModelGroup needs to be passed
  * or created on the fly. This JMG needs to stay alive during the lifetime of the trajectory.
  * For now, only the trajectory path is considered. Timings, velocities, etc. are ignored.
+ * Without timing, time parameterization is left to the caller, see computeTimeStamps() (timing.h).
  */
 robot_trajectory::RobotTrajectoryPtr
 merge(const std::vector<robot_trajectory::RobotTrajectoryConstPtr>& sub_trajectories,
-      const moveit::core::RobotState& base_state, moveit::core::JointModelGroup*& merged_group);
+      const moveit::core::RobotState& base_state, moveit::core::JointModelGroup*& merged_group, bool timing = true);
 }  // namespace task_constructor
 }  // namespace moveit
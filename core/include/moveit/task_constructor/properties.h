@@ -114,6 +114,9 @@ public:
 	static std::string serialize(const boost::any& value);
 	static boost::any deserialize(const std::string& type_name, const std::string& wire);
 	std::string serialize() const { return serialize(value()); }
+	/// can value be serialized, i.e. distinguished from other values by its serialization? (true if empty)
+	static bool serializable(const boost::any& value);
+	bool serializable() const { return serializable(value()); }
 
 	/// get description text
 	const std::string& description() const { return description_; }
@@ -207,7 +210,11 @@ template <typename T>
 class PropertySerializer : protected PropertySerializerBase
 {
 public:
-	PropertySerializer() { insert(typeid(T), typeName<T>(), &serialize, &deserialize); }
+	PropertySerializer() {
+		// register dummySerialize itself for non-serializable types, such that they can be identified
+		insert(typeid(T), typeName<T>(), hasSerialize<T>::value ? SerializeFunction(&serialize) : &dummySerialize,
+		       &deserialize);
+	}
 
 	template <class Q = T>
 	static typename std::enable_if<ros::message_traits::IsMessage<Q>::value, std::string>::type typeName() {
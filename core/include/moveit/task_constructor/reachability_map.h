@@ -0,0 +1,115 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2026, MoveIt Task Constructor contributors
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of the copyright holder nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+/* Voxelized map of reachable tip poses to prioritize IK targets */
+
+#pragma once
+
+#include <moveit/macros/class_forward.h>
+#include <Eigen/Geometry>
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace moveit {
+namespace core {
+MOVEIT_CLASS_FORWARD(RobotModel)
+}
+}
+
+namespace moveit {
+namespace task_constructor {
+
+MOVEIT_CLASS_FORWARD(ReachabilityMap)
+
+/** Precomputed map of tip link poses reachable by a planning group
+ *
+ * Tip positions, expressed relative to the group's base link, are voxelized.
+ * For each voxel, a bitmask records which approach directions (tip's z axis, discretized into
+ * 26 directions) are reachable. The map is computed by sampling forward kinematics, ignoring
+ * collisions, and dilated by one voxel. Lookups are O(1).
+ * As sampling may miss rarely reached poses, the map is not guaranteed to be conservative:
+ * use it to prioritize likely reachable targets, not to reject others.
+ *
+ * Maps are stored on disk and memory-mapped when loaded, such that large maps load instantly.
+ */
+class ReachabilityMap
+{
+public:
+	~ReachabilityMap();
+	ReachabilityMap(const ReachabilityMap&) = delete;
+	ReachabilityMap& operator=(const ReachabilityMap&) = delete;
+
+	/// compute map for given group and tip link from num_samples random configurations
+	static ReachabilityMapPtr compute(const moveit::core::RobotModelConstPtr& robot_model, const std::string& group,
+	                                  const std::string& tip, double resolution = 0.05, size_t num_samples = 1000000);
+	/// load (memory-map) map from file, throws std::runtime_error on failure
+	static ReachabilityMapConstPtr load(const std::string& filename);
+	/// save map to file, throws std::runtime_error on failure
+	void save(const std::string& filename) const;
+
+	const std::string& robotName() const { return robot_name_; }
+	const std::string& group() const { return group_; }
+	const std::string& baseLink() const { return base_link_; }
+	const std::string& tip() const { return tip_; }
+	double resolution() const { return resolution_; }
+
+	/// is the tip pose (relative to base link) likely reachable?
+	bool reachable(const Eigen::Isometry3d& tip_pose) const;
+	/// number of reachable approach directions in the voxel of the tip pose (relative to base link)
+	unsigned int numDirections(const Eigen::Isometry3d& tip_pose) const;
+
+private:
+	ReachabilityMap() = default;
+	/// mask of voxel containing position, 0 if outside the map
+	uint32_t voxel(const Eigen::Vector3d& position) const;
+	static unsigned int direction(const Eigen::Vector3d& z);
+
+	std::string robot_name_;
+	std::string group_;
+	std::string base_link_;
+	std::string tip_;
+	double resolution_ = 0.0;
+	Eigen::Vector3d origin_;  // lower corner of the grid
+	uint32_t dims_[3] = { 0, 0, 0 };
+
+	// voxel masks, either owned or memory-mapped
+	std::vector<uint32_t> owned_masks_;
+	const uint32_t* masks_ = nullptr;
+	void* mapping_ = nullptr;
+	size_t mapping_size_ = 0;
+};
+}  // namespace task_constructor
+}  // namespace moveit
@@ -59,6 +59,8 @@ public:
 	void setMaxVelocityScaling(double factor) { setProperty("max_velocity_scaling_factor", factor); }
 	void setMaxAccelerationScaling(double factor) { setProperty("max_acceleration_scaling_factor", factor); }
 
+	using PlannerInterface::plan;
+
 	void init(const moveit::core::RobotModelConstPtr& robot_model) override;
 
 	bool plan(const planning_scene::PlanningSceneConstPtr& from, const planning_scene::PlanningSceneConstPtr& to,
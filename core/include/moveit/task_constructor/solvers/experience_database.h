@@ -0,0 +1,133 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2026, MoveIt Task Constructor contributors
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of the copyright holder nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+/* database of previously planned trajectories to retrieve and repair */
+
+#pragma once
+
+#include <moveit/macros/class_forward.h>
+#include <moveit_msgs/Constraints.h>
+
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace planning_scene {
+MOVEIT_CLASS_FORWARD(PlanningScene)
+}
+namespace robot_trajectory {
+MOVEIT_CLASS_FORWARD(RobotTrajectory)
+}
+namespace moveit {
+namespace core {
+MOVEIT_CLASS_FORWARD(JointModelGroup)
+MOVEIT_CLASS_FORWARD(RobotState)
+}
+}
+
+namespace moveit {
+namespace task_constructor {
+namespace solvers {
+
+MOVEIT_CLASS_FORWARD(ExperienceDatabase)
+
+/** Store successful joint-space paths, indexed by their quantized start and goal configurations
+ *
+ * A query retrieves the nearest path stored for the same or neighboring start and goal cells,
+ * validates it against the current scene, and repairs invalid segments by replanning them locally.
+ * The database can be saved to and loaded from a local file to persist experience across runs.
+ */
+class ExperienceDatabase
+{
+public:
+	/// function used to plan (repair) a path segment between two scenes
+	using PlanFunction = std::function<bool(const planning_scene::PlanningSceneConstPtr& from,
+	                                        const planning_scene::PlanningSceneConstPtr& to,
+	                                        robot_trajectory::RobotTrajectoryPtr& result)>;
+
+	/// resolution (in joint space units) of start and goal quantization
+	ExperienceDatabase(double resolution = 0.1);
+
+	double resolution() const { return resolution_; }
+	/// max joint step used to validate retrieved paths
+	void setMaxStep(double max_step) { max_step_ = max_step; }
+	/// max number of paths stored per pair of start and goal cells
+	void setCapacityPerCell(size_t capacity) { capacity_per_cell_ = capacity; }
+
+	/// store the path of a successfully planned trajectory
+	void add(const robot_trajectory::RobotTrajectory& trajectory);
+
+	/** retrieve a valid (untimed) path connecting the current states of from and to
+	 *
+	 * Invalid segments of the stored path are replanned via repair.
+	 * Returns false if no path is stored for these or neighboring cells,
+	 * the start state is invalid or out of bounds, or repairing failed.
+	 */
+	bool retrieve(const planning_scene::PlanningSceneConstPtr& from, const planning_scene::PlanningSceneConstPtr& to,
+	              const moveit::core::JointModelGroup* jmg, const moveit_msgs::Constraints& path_constraints,
+	              const PlanFunction& repair, robot_trajectory::RobotTrajectoryPtr& result);
+
+	size_t size() const;
+	void clear();
+	/// number of successful retrievals and how many of them required repair
+	size_t numHits() const { return num_hits_; }
+	size_t numRepairs() const { return num_repairs_; }
+
+	/// save all stored paths to file, return success
+	bool save(const std::string& filename) const;
+	/// load (and add) paths from file, return success
+	bool load(const std::string& filename);
+
+private:
+	using Path = std::vector<std::vector<double>>;
+	/// quantized start and goal configuration
+	using Cell = std::vector<int64_t>;
+	Cell cell(const std::vector<double>& start, const std::vector<double>& goal) const;
+	void add(const std::string& group, Path&& path);
+
+	double resolution_;
+	double max_step_ = 0.1;
+	size_t capacity_per_cell_ = 4;
+	// per group, map from cells to stored paths, most recent last
+	std::map<std::string, std::map<Cell, std::vector<Path>>> paths_;
+	size_t num_hits_ = 0;
+	size_t num_repairs_ = 0;
+	mutable std::mutex mutex_;
+};
+}  // namespace solvers
+}  // namespace task_constructor
+}  // namespace moveit
@@ -53,6 +53,8 @@ class JointInterpolationPlanner : public PlannerInterface
 public:
 	JointInterpolationPlanner();
 
+	using PlannerInterface::plan;
+
 	void init(const moveit::core::RobotModelConstPtr& robot_model) override;
 
 	bool plan(const planning_scene::PlanningSceneConstPtr& from, const planning_scene::PlanningSceneConstPtr& to,
@@ -39,11 +39,16 @@
 #pragma once
 
 #include <moveit/task_constructor/solvers/planner_interface.h>
+#include <moveit/task_constructor/solvers/experience_database.h>
 #include <moveit/macros/class_forward.h>
+#include <moveit_msgs/MotionPlanRequest.h>
 
 namespace planning_pipeline {
 MOVEIT_CLASS_FORWARD(PlanningPipeline)
 }
+namespace planning_interface {
+struct MotionPlanResponse;
+}
 
 namespace moveit {
 namespace task_constructor {
@@ -61,19 +66,47 @@ public:
 
 	void setPlannerId(const std::string& planner) { setProperty("planner", planner); }
 
+	/** retrieve (and repair) joint-space paths from given experience database before planning from scratch
+	 *
+	 * Newly planned paths are added to the database. Share a database between planners and
+	 * load() / save() it to persist experience across runs.
+	 * Retrieved paths bypass the pipeline's request adapters. Thus they are only used if the start state
+	 * is valid and within bounds, i.e. if the adapters wouldn't need to fix it, and are timed like pipeline results.
+	 */
+	void setExperienceDatabase(const ExperienceDatabasePtr& experience) { experience_ = experience; }
+	const ExperienceDatabasePtr& experienceDatabase() const { return experience_; }
+
 	void init(const moveit::core::RobotModelConstPtr& robot_model) override;
+	std::function<void(robot_trajectory::RobotTrajectory&)> deferredTiming() const override;
+	/// the planning pipeline, shared by planners created for the same pipeline name (see Task::createPlanner)
+	const void* concurrencyKey() const override;
 
 	bool plan(const planning_scene::PlanningSceneConstPtr& from, const planning_scene::PlanningSceneConstPtr& to,
 	          const core::JointModelGroup* jmg, double timeout, robot_trajectory::RobotTrajectoryPtr& result,
 	          const moveit_msgs::Constraints& path_constraints = moveit_msgs::Constraints()) override;
 
+	/// plan to any of the goals with a single request (comprising multiple goal constraints)
+	bool plan(const planning_scene::PlanningSceneConstPtr& from,
+	          const std::vector<planning_scene::PlanningSceneConstPtr>& to, const core::JointModelGroup* jmg,
+	          double timeout, robot_trajectory::RobotTrajectoryPtr& result, size_t& reached,
+	          const moveit_msgs::Constraints& path_constraints = moveit_msgs::Constraints()) override;
+
 	bool plan(const planning_scene::PlanningSceneConstPtr& from, const moveit::core::LinkModel& link,
 	          const Eigen::Isometry3d& target, const core::JointModelGroup* jmg, double timeout,
 	          robot_trajectory::RobotTrajectoryPtr& result,
 	          const moveit_msgs::Constraints& path_constraints = moveit_msgs::Constraints()) override;
 
 protected:
+	/// solve a motion plan request, by default using the planning pipeline, which is terminated on cancellation
+	virtual bool generatePlan(const planning_scene::PlanningSceneConstPtr& from,
+	                          const moveit_msgs::MotionPlanRequest& req, ::planning_interface::MotionPlanResponse& res);
+	bool planPipeline(const planning_scene::PlanningSceneConstPtr& from,
+	                  const planning_scene::PlanningSceneConstPtr& to, const core::JointModelGroup* jmg,
+	                  double timeout, robot_trajectory::RobotTrajectoryPtr& result,
+	                  const moveit_msgs::Constraints& path_constraints);
+
 	planning_pipeline::PlanningPipelinePtr planner_;
+	ExperienceDatabasePtr experience_;
 };
 }  // namespace solvers
 }  // namespace task_constructor
@@ -43,6 +43,9 @@
 #include <moveit/task_constructor/properties.h>
 #include <Eigen/Geometry>
 
+#include <functional>
+#include <vector>
+
 namespace planning_scene {
 MOVEIT_CLASS_FORWARD(PlanningScene)
 }
@@ -78,12 +81,39 @@ public:
 
 	virtual void init(const moveit::core::RobotModelConstPtr& robot_model) = 0;
 
+	/// time parameterization using this planner's velocity and acceleration scaling
+	void computeTimeStamps(robot_trajectory::RobotTrajectory& trajectory) const;
+	/// estimate trajectory's duration (see timing.h) using this planner's velocity scaling
+	double estimateDuration(const robot_trajectory::RobotTrajectory& trajectory) const;
+	/** timing to be applied to trajectories returned by plan() once they are actually used
+	 *
+	 * Empty if the planner returns timed trajectories, i.e. if lazy_timing is disabled.
+	 */
+	virtual std::function<void(robot_trajectory::RobotTrajectory&)> deferredTiming() const;
+	/** planners returning the same key must not plan concurrently
+	 *
+	 * By default, planner instances are not assumed to be thread-safe. Planners sharing an underlying
+	 * resource (e.g. a planning pipeline) should return that instead.
+	 */
+	virtual const void* concurrencyKey() const { return this; }
+
 	/// plan trajectory between to robot states
 	virtual bool plan(const planning_scene::PlanningSceneConstPtr& from, const planning_scene::PlanningSceneConstPtr& to,
 	                  const moveit::core::JointModelGroup* jmg, double timeout,
 	                  robot_trajectory::RobotTrajectoryPtr& result,
 	                  const moveit_msgs::Constraints& path_constraints = moveit_msgs::Constraints()) = 0;
 
+	/** plan trajectory between from and any of the goal states, returning the index of the reached goal
+	 *
+	 * Goals should be sorted by preference. By default, they are attempted one after the other
+	 * (sharing the timeout). Planners supporting multiple goals natively should override this.
+	 */
+	virtual bool plan(const planning_scene::PlanningSceneConstPtr& from,
+	                  const std::vector<planning_scene::PlanningSceneConstPtr>& to,
+	                  const moveit::core::JointModelGroup* jmg, double timeout,
+	                  robot_trajectory::RobotTrajectoryPtr& result, size_t& reached,
+	                  const moveit_msgs::Constraints& path_constraints = moveit_msgs::Constraints());
+
 	/// plan trajectory from current robot state to Cartesian target
 	virtual bool plan(const planning_scene::PlanningSceneConstPtr& from, const moveit::core::LinkModel& link,
 	                  const Eigen::Isometry3d& target, const moveit::core::JointModelGroup* jmg, double timeout,
@@ -0,0 +1,96 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2026, MoveIt Task Constructor contributors
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of the copyright holder nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+/* plan using a persistent, lazily validated roadmap */
+
+#pragma once
+
+#include <moveit/task_constructor/solvers/planner_interface.h>
+#include <moveit/macros/class_forward.h>
+
+#include <map>
+#include <memory>
+#include <mutex>
+
+namespace moveit {
+namespace task_constructor {
+namespace solvers {
+
+MOVEIT_CLASS_FORWARD(RoadmapPlanner)
+
+/** Answer repeated joint-space queries from a roadmap that persists across calls
+ *
+ * For each planning group and collision environment, a probabilistic roadmap is kept.
+ * Edges are only collision-checked when they become part of a candidate path (lazy PRM):
+ * invalid edges are removed and the graph search is repeated. Only if start and goal are
+ * disconnected, the roadmap is grown by sampling new configurations.
+ * Hence, many Connect queries in a static environment are answered by a graph search only.
+ */
+class RoadmapPlanner : public PlannerInterface
+{
+public:
+	RoadmapPlanner();
+	~RoadmapPlanner() override;
+
+	using PlannerInterface::plan;
+
+	void init(const moveit::core::RobotModelConstPtr& robot_model) override;
+
+	bool plan(const planning_scene::PlanningSceneConstPtr& from, const planning_scene::PlanningSceneConstPtr& to,
+	          const core::JointModelGroup* jmg, double timeout, robot_trajectory::RobotTrajectoryPtr& result,
+	          const moveit_msgs::Constraints& path_constraints = moveit_msgs::Constraints()) override;
+
+	/// solve IK for the target pose, then plan in joint space
+	bool plan(const planning_scene::PlanningSceneConstPtr& from, const moveit::core::LinkModel& link,
+	          const Eigen::Isometry3d& target, const core::JointModelGroup* jmg, double timeout,
+	          robot_trajectory::RobotTrajectoryPtr& result,
+	          const moveit_msgs::Constraints& path_constraints = moveit_msgs::Constraints()) override;
+
+	/// discard all roadmaps
+	void clear();
+	/// number of currently maintained roadmaps
+	size_t numRoadmaps() const;
+	/// number of vertices of all roadmaps
+	size_t numVertices() const;
+
+private:
+	struct Roadmap;
+	std::shared_ptr<Roadmap> roadmap(const std::string& key);
+
+	std::map<std::string, std::shared_ptr<Roadmap>> roadmaps_;
+	mutable std::mutex mutex_;
+};
+}  // namespace solvers
+}  // namespace task_constructor
+}  // namespace moveit
@@ -138,6 +138,18 @@ private:
 };
 std::ostream& operator<<(std::ostream& os, const InitStageException& e);
 
+/// estimated memory (in bytes) held by a stage
+struct MemoryUsage
+{
+	size_t states = 0;  // InterfaceStates created by the stage
+	size_t scenes = 0;  // planning scenes (diffs) referenced by these states
+	size_t trajectories = 0;  // trajectory waypoints of solutions and failures
+	size_t markers = 0;  // markers of solutions and failures
+
+	size_t total() const { return states + scenes + trajectories + markers; }
+	MemoryUsage& operator+=(const MemoryUsage& other);
+};
+
 class ContainerBase;
 class StagePrivate;
 class Stage
@@ -159,6 +171,18 @@ public:
 		PARENT = 2,
 		INTERFACE = 4,
 	};
+	/** Policies to limit the number of stored failures
+	 *
+	 * - KEEP_ALL stores all failures.
+	 * - KEEP_LAST stores the most recent failures only (capacity 0: only count failures).
+	 * - RESERVOIR stores a uniformly sampled subset of all failures.
+	 */
+	enum FailureRetention
+	{
+		KEEP_ALL,
+		KEEP_LAST,
+		RESERVOIR,
+	};
 	virtual ~Stage();
 
 	/// auto-convert Stage to StagePrivate* when needed
@@ -185,8 +209,8 @@ public:
 	 * The logic of the individual stage should ensure this limit is respected.
 	 */
 	void setTimeout(double timeout) { setProperty("timeout", timeout); }
-	/// timeout of stage per computation
-	double timeout() const { return properties().get<double>("timeout"); }
+	/// timeout of stage per computation, limited by the time remaining until the planning deadline
+	double timeout() const;
 
 	/** set marker namespace for solutions
 	 *
@@ -217,6 +241,10 @@ public:
 	void silentFailure();
 	/// should we generate failure solutions?
 	bool storeFailures() const;
+	/// limit the number of stored failures (numFailures() still counts all of them)
+	void setFailureRetention(FailureRetention policy, size_t capacity = 0);
+	/// flatten deep scene diff chains of states created by this stage and (unless configured otherwise) its children
+	void setSceneFlattening(const InterfaceState::SceneFlattening& policy);
 
 	/// get the stage's property map
 	PropertyMap& properties();
@@ -228,6 +256,16 @@ public:
 	/// analyze source of error and report accordingly
 	[[noreturn]] void reportPropertyError(const Property::error& e);
 	double getTotalComputeTime() const;
+	/// number of compute() calls
+	size_t numComputeCalls() const;
+	/// compute time (in seconds) of a single compute() call not exceeded by the given fraction (0..1) of calls
+	double computeTimePercentile(double fraction) const;
+	/// maximum compute time (in seconds) of a single compute() call
+	double maxComputeTime() const;
+	/// maximum number of states that were pending in the start (FORWARD) or end (BACKWARD) interface
+	size_t maxPendingStates(Interface::Direction dir) const;
+	/// estimate memory held by this stage (excluding children)
+	MemoryUsage memoryUsage() const;
 
 protected:
 	/// Stage can only be instantiated through derived classes
@@ -273,6 +311,20 @@ public:
 	};
 	void restrictDirection(Direction dir);
 
+	/** reuse results of previous computations for identical input, also across reset() and replanning
+	 *
+	 * Input is identified by the robot state and collision environment of the input scene,
+	 * the properties of the input state, and the stage's properties. When replanning after small scene
+	 * changes, only stages affected by the change need to compute again. Only enable this for stages
+	 * that deterministically depend on these inputs only. Inputs having properties without serialization
+	 * are never cached. The least recently used results are evicted when exceeding 4096 cached inputs.
+	 */
+	void setResultCaching(bool enable);
+	bool resultCaching() const;
+	void clearResultCache();
+	/// number of computations answered from the cache
+	size_t numCacheHits() const;
+
 	virtual void computeForward(const InterfaceState& from) = 0;
 	virtual void computeBackward(const InterfaceState& to) = 0;
 
@@ -368,7 +420,24 @@ public:
 
 	virtual void compute(const InterfaceState& from, const InterfaceState& to) = 0;
 
+	/** compute up to n pending state pairs sharing their start (or end) state at once, see computeGroup()
+	 *
+	 * This allows, e.g., to issue a single multi-goal planning request for all IK solutions
+	 * compatible with a given start state instead of n individual ones.
+	 */
+	void setMaxGroupSize(size_t n);
+	size_t maxGroupSize() const;
+
 protected:
+	using StatePairList = std::vector<std::pair<const InterfaceState*, const InterfaceState*>>;
+	/** connect a group of state pairs, all sharing either their start or their end state
+	 *
+	 * Pairs are sorted by priority. By default, they are computed one by one.
+	 * Pairs neither connected nor reported as failure should be returned: they are queued again.
+	 * If all pairs are returned, the group failed as a whole and its pairs are subsequently computed individually.
+	 */
+	virtual StatePairList computeGroup(const StatePairList& pairs);
+
 	/// register solution as a solution connecting states from -> to
 	void connect(const InterfaceState& from, const InterfaceState& to, const SolutionBasePtr& solution);
 
@@ -41,11 +41,16 @@
 #include <moveit/task_constructor/stage.h>
 #include <moveit/task_constructor/storage.h>
 #include <moveit/task_constructor/cost_queue.h>
+#include <moveit/task_constructor/trace.h>
 
 #include <ros/ros.h>
 
 #include <ostream>
+#include <set>
+#include <unordered_map>
 #include <chrono>
+#include <array>
+#include <random>
 
 // define pimpl() functions accessing correctly casted pimpl_ pointer
 #define PIMPL_FUNCTIONS(Class)                                                                       \
@@ -55,6 +60,33 @@
 namespace moveit {
 namespace task_constructor {
 
+/// exact key describing robot state and collision environment of a scene (defined in storage.cpp)
+std::string sceneFingerprint(const planning_scene::PlanningScene& scene);
+/// exact key describing the collision environment (world, ACM, attached bodies) of a scene, ignoring joint positions
+std::string environmentFingerprint(const planning_scene::PlanningScene& scene);
+
+/** Histogram of compute() durations
+ *
+ * Buckets are logarithmically spaced by a factor of sqrt(2), starting at 1us.
+ * Thus percentiles are accurate up to this factor, while recording is cheap.
+ */
+class ComputeTimeHistogram
+{
+public:
+	static constexpr size_t NUM_BUCKETS = 64;
+
+	void add(double seconds);
+	/// duration (in seconds) not exceeded by the given fraction (0..1) of samples
+	double percentile(double fraction) const;
+	inline double max() const { return max_; }
+	inline size_t count() const { return count_; }
+
+private:
+	std::array<size_t, NUM_BUCKETS> buckets_{};
+	size_t count_ = 0;
+	double max_ = 0.0;
+};
+
 class ContainerBase;
 class StagePrivate
 {
@@ -83,6 +115,27 @@ public:
 	virtual bool canCompute() const = 0;
 	virtual void compute() = 0;
 
+	/// priority of the best (partial solution) state waiting to be processed, used for scheduling
+	virtual InterfaceState::Priority pendingPriority() const;
+	/** drop pending states whose (accumulated) cost exceeds the given bound
+	 *
+	 * Assuming non-negative costs, such partial solutions cannot become part of a solution better than bound.
+	 * States arriving later are checked against the bound too. Solutions only leading to dropped states are released.
+	 */
+	virtual void pruneStates(double bound);
+	/** release data of solutions exceeding the given cost bound, which are not listed in keep
+	 *
+	 * Like pruneStates(), this assumes non-negative costs. Solution objects remain in place,
+	 * because they are referenced from states and parent solutions.
+	 */
+	virtual void releaseSolutions(double bound, const std::set<const SolutionBase*>& keep);
+	/** discard all but the best keep solutions
+	 *
+	 * Solutions still referenced elsewhere (e.g. obtained via Task::bestSolution()) stay intact
+	 * until these references are gone.
+	 */
+	void dropSolutions(size_t keep);
+
 	inline const Stage* me() const { return me_; }
 	inline Stage* me() { return me_; }
 	inline const std::string& name() const { return name_; }
@@ -145,13 +198,43 @@ public:
 	void connect(const InterfaceState& from, const InterfaceState& to, const SolutionBasePtr& solution);
 
 	bool storeSolution(const SolutionBasePtr& solution);
+	/// apply failure retention policy to decide about storing a new failure, evicting old ones as needed
+	bool retainFailure();
+	void evictFailure(std::list<SolutionBaseConstPtr>::iterator it);
+	/// remember states created for a failure, to be released when evicting it
+	void trackFailureStates(const SolutionBase& failure,
+	                        std::initializer_list<std::list<InterfaceState>::iterator> states);
 	void newSolution(const SolutionBasePtr& solution);
 	bool storeFailures() const { return introspection_ != nullptr; }
 	void runCompute() {
+		// no time left: skip computation to keep the response time bounded
+		if (deadline_ != std::chrono::steady_clock::time_point::max() && std::chrono::steady_clock::now() >= deadline_)
+			return;
+
+		// record queue depth of pull interfaces
+		if (starts_)
+			max_pending_starts_ = std::max(max_pending_starts_, starts_->size());
+		if (ends_)
+			max_pending_ends_ = std::max(max_pending_ends_, ends_->size());
+
+		trace::Scope scope("compute", name_.c_str());
 		auto compute_start_time = std::chrono::steady_clock::now();
 		compute();
 		auto compute_stop_time = std::chrono::steady_clock::now();
-		total_compute_time_ += compute_stop_time - compute_start_time;
+		std::chrono::duration<double> duration = compute_stop_time - compute_start_time;
+		total_compute_time_ += duration;
+		compute_time_histogram_.add(duration.count());
+		++num_computes_;
+	}
+
+	/// set wall-clock deadline for computations of this stage (assigned by parent)
+	inline void setDeadline(std::chrono::steady_clock::time_point deadline) { deadline_ = deadline; }
+	inline std::chrono::steady_clock::time_point deadline() const { return deadline_; }
+	/// time (in seconds) remaining until deadline, infinity if there is no deadline
+	double remainingTime() const;
+	/// average duration of a compute() call (in seconds), zero if never computed
+	double averageComputeTime() const {
+		return num_computes_ ? total_compute_time_.count() / num_computes_ : 0.0;
 	}
 
 protected:
@@ -165,6 +248,15 @@ protected:
 
 	// The total compute time
 	std::chrono::duration<double> total_compute_time_;
+	// number of compute() calls
+	size_t num_computes_ = 0;
+	// distribution of durations of compute() calls
+	ComputeTimeHistogram compute_time_histogram_;
+	// high-water marks of pull interfaces' sizes
+	size_t max_pending_starts_ = 0;
+	size_t max_pending_ends_ = 0;
+	// computations should finish before this point in time
+	std::chrono::steady_clock::time_point deadline_ = std::chrono::steady_clock::time_point::max();
 
 	// functions called for each new solution
 	std::list<Stage::SolutionCallback> solution_cbs_;
@@ -172,7 +264,17 @@ protected:
 	std::list<InterfaceState> states_;  // storage for created states
 	ordered<SolutionBaseConstPtr> solutions_;
 	std::list<SolutionBaseConstPtr> failures_;
+	// dropped solutions, which are still referenced by users
+	std::list<SolutionBaseConstPtr> dropped_;
 	size_t num_failures_ = 0;  // num of failures if not stored
+	Stage::FailureRetention failure_retention_ = Stage::KEEP_ALL;
+	size_t failure_capacity_ = 0;
+	std::minstd_rand failure_sampler_;  // random generator for RESERVOIR sampling
+	// states created for failures that might be evicted (i.e. not with KEEP_ALL)
+	std::unordered_map<const SolutionBase*, std::vector<std::list<InterfaceState>::iterator>> failure_states_;
+	// flattening of scenes of created states, inherited from parent if not configured
+	InterfaceState::SceneFlattening scene_flattening_;
+	bool scene_flattening_configured_ = false;
 
 private:
 	// !! items write-accessed only by ContainerBasePrivate to maintain hierarchy !!
@@ -228,6 +330,32 @@ public:
 	bool hasEndState() const;
 	const InterfaceState& fetchEndState();
 
+	// result of a previous computation, replayed for identical input
+	struct CachedResult
+	{
+		InterfaceState state;
+		SubTrajectory trajectory;
+	};
+	struct CacheEntry
+	{
+		std::vector<CachedResult> results;
+		std::list<const std::string*>::iterator lru;  // position in result_cache_lru_
+	};
+	bool result_caching_ = false;
+	// results indexed by direction, input scene and properties
+	std::unordered_map<std::string, CacheEntry> result_cache_;
+	// keys of result_cache_, least recently used first
+	std::list<const std::string*> result_cache_lru_;
+	// results of the current computation are recorded here
+	std::vector<CachedResult>* recording_ = nullptr;
+	size_t num_cache_hits_ = 0;
+
+	// call computeForward() / computeBackward() or replay cached results
+	void computeCached(const InterfaceState& state, PropagatingEitherWay::Direction dir);
+	// cache key of given input, false if the input cannot be identified by its serialization
+	bool cacheKey(const InterfaceState& state, PropagatingEitherWay::Direction dir, std::string& key) const;
+	void clearResultCache();
+
 protected:
 	// drop states corresponding to failed (infinite-cost) trajectories
 	void dropFailedStarts(Interface::iterator state);
@@ -297,6 +425,8 @@ public:
 	InterfaceFlags requiredInterface() const override;
 	bool canCompute() const override;
 	void compute() override;
+	InterfaceState::Priority pendingPriority() const override;
+	void pruneStates(double bound) override;
 
 private:
 	// get informed when new start or end state becomes available
@@ -305,6 +435,10 @@ private:
 
 	// ordered list of pending state pairs
 	ordered<StatePair, StatePairLess> pending;
+	// max number of pairs sharing a start or end state to compute at once
+	size_t max_group_size_ = 1;
+	// pending pairs of groups that failed as a whole: compute them individually
+	std::set<std::pair<const InterfaceState*, const InterfaceState*>> ungrouped_;
 };
 PIMPL_FUNCTIONS(Connecting)
 }  // namespace task_constructor
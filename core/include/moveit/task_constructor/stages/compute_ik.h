@@ -38,8 +38,10 @@
 
 #include <moveit/task_constructor/container.h>
 #include <moveit/task_constructor/cost_queue.h>
+#include <moveit/task_constructor/reachability_map.h>
 #include <geometry_msgs/PoseStamped.h>
 #include <Eigen/Geometry>
+#include <deque>
 
 namespace moveit {
 namespace core {
@@ -109,9 +111,13 @@ public:
 	void setMaxIKSolutions(uint32_t n) { setProperty("max_ik_solutions", n); }
 	void setIgnoreCollisions(bool flag) { setProperty("ignore_collisions", flag); }
 	void setMinSolutionDistance(double distance) { setProperty("min_solution_distance", distance); }
+	/// defer targets outside the map's reachable workspace until all others are processed
+	/// (map must match group and IK link)
+	void setReachabilityMap(const ReachabilityMapConstPtr& map) { setProperty("reachability_map", map); }
 
 protected:
 	ordered<const SolutionBase*> upstream_solutions_;
+	std::deque<const SolutionBase*> deferred_solutions_;  // unreachable according to reachability map
 };
 }  // namespace stages
 }  // namespace task_constructor
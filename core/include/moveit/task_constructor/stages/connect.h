@@ -60,6 +60,10 @@ namespace stages {
  * specified order. Each planner only plan for joints within the corresponding planning group.
  * Finally, an attempt is made to merge the sub trajectories of individual planning results.
  * If this fails, the sequential planning result is returned.
+ *
+ * When planning for a single group, setMaxGroupSize() allows to connect a start state to
+ * many compatible end states (or vice versa) with a single multi-goal planning request.
+ * Only the pair actually reached is connected then.
  */
 class Connect : public Connecting
 {
@@ -70,7 +74,14 @@ public:
 	enum MergeMode
 	{
 		SEQUENTIAL = 0,
-		WAYPOINTS = 1
+		WAYPOINTS = 1,
+		/** plan disjoint groups concurrently from the start state, then merge as WAYPOINTS
+		 *
+		 * Falls back to sequential planning if the merged trajectory is invalid (or planning failed).
+		 * Planners sharing an underlying resource (see PlannerInterface::concurrencyKey()) are called sequentially,
+		 * e.g. PipelinePlanners created for the same pipeline name. Distinct ones are called concurrently.
+		 */
+		PARALLEL = 2
 	};
 
 	using GroupPlannerVector = std::vector<std::pair<std::string, solvers::PlannerInterfacePtr> >;
@@ -85,12 +96,22 @@ public:
 	void compute(const InterfaceState& from, const InterfaceState& to) override;
 
 protected:
+	StatePairList computeGroup(const StatePairList& pairs) override;
+	/** plan all groups concurrently and merge (PARALLEL mode), first provides the (reusable) plan of the first group
+	 *
+	 * Groups whose planners share a concurrencyKey() are planned serially, splitting the timeout between them.
+	 */
+	bool computeParallel(const InterfaceState& from, const InterfaceState& to,
+	                     robot_trajectory::RobotTrajectoryPtr& first);
+
 	SolutionSequencePtr makeSequential(const std::vector<robot_trajectory::RobotTrajectoryConstPtr>& sub_trajectories,
 	                                   const std::vector<planning_scene::PlanningSceneConstPtr>& intermediate_scenes,
 	                                   const InterfaceState& from, const InterfaceState& to);
 	SubTrajectoryPtr merge(const std::vector<robot_trajectory::RobotTrajectoryConstPtr>& sub_trajectories,
 	                       const std::vector<planning_scene::PlanningSceneConstPtr>& intermediate_scenes,
 	                       const moveit::core::RobotState& state);
+	/// estimated total duration of sub trajectories, planned by the planners in order
+	double estimateDuration(const std::vector<robot_trajectory::RobotTrajectoryConstPtr>& sub_trajectories) const;
 
 protected:
 	GroupPlannerVector planner_;
@@ -43,6 +43,7 @@
 #include <moveit/task_constructor/properties.h>
 #include <moveit/task_constructor/cost_queue.h>
 #include <moveit_task_constructor_msgs/Solution.h>
+#include <moveit_msgs/PlanningScene.h>
 #include <visualization_msgs/MarkerArray.h>
 
 #include <list>
@@ -59,6 +60,12 @@ namespace robot_trajectory {
 MOVEIT_CLASS_FORWARD(RobotTrajectory)
 }
 
+namespace moveit {
+namespace core {
+class JointModelGroup;
+}
+}  // namespace moveit
+
 namespace moveit {
 namespace task_constructor {
 
@@ -96,15 +103,64 @@ public:
 		bool operator<(const Priority& other) const;
 	};
 	using Solutions = std::deque<SolutionBase*>;
+	/** Policy to flatten deep chains of scene diffs (a zero limit disables the criterion)
+	 *
+	 * Deep chains of scene diffs, accumulating along a pipeline of stages, slow down every lookup
+	 * of world or ACM and keep all intermediate scenes alive.
+	 */
+	struct SceneFlattening
+	{
+		/// flatten scenes having more parent scenes
+		unsigned int max_depth = 0;
+		/// flatten scenes whose lookups of robot state, ACM, and transforms traverse more parent scenes in total
+		unsigned int max_lookup_cost = 0;
+
+		bool enabled() const { return max_depth > 0 || max_lookup_cost > 0; }
+	};
+	/// modifications applied to the scene of a lazy InterfaceState
+	using SceneDelta = std::function<void(planning_scene::PlanningScene&)>;
 
 	/// create an InterfaceState from a planning scene
 	InterfaceState(const planning_scene::PlanningScenePtr& ps);
 	InterfaceState(const planning_scene::PlanningSceneConstPtr& ps);
 
+	/** create a lazy InterfaceState, deriving its scene from parent on first access of scene()
+	 *
+	 * The scene is created as a diff of parent, setting the joint values of group (if given)
+	 * and finally applying delta (if given). Thus scene creation and forward kinematics
+	 * are only paid for states actually used. Copies of the state share the created scene.
+	 */
+	InterfaceState(const planning_scene::PlanningSceneConstPtr& parent, const moveit::core::JointModelGroup* group,
+	               const std::vector<double>& joint_values, const SceneDelta& delta = SceneDelta());
+
 	/// copy an existing InterfaceState, but not including incoming/outgoing trajectories
 	InterfaceState(const InterfaceState& other);
 
-	inline const planning_scene::PlanningSceneConstPtr& scene() const { return scene_; }
+	/// flatten the scene (of a lazy state: once created) if it exceeds the limits of policy
+	void flattenScene(const SceneFlattening& policy);
+	/// number of scenes flattened so far
+	static size_t numFlattenedScenes();
+
+	/** Enable interning of scenes passed to the constructor
+	 *
+	 * Scenes with identical collision environment (world objects, ACM, attached bodies) then share a common,
+	 * immutable base scene, only overriding the robot state. This replaces flattening of diff chains.
+	 * Primitive shapes are compared by their dimensions, meshes and octrees by identity,
+	 * thus these need to originate from the same source scene to be shared.
+	 */
+	static void setSceneInterning(bool enable);
+	static bool sceneInterning();
+	/// number of scenes that reused an existing base scene
+	static size_t numInternedScenes();
+
+	/// scene of the state, creating the scene of a lazy state on first access (thread-safe)
+	inline const planning_scene::PlanningSceneConstPtr& scene() const { return scene_ ? scene_ : materialize(); }
+	/// is a scene available (but possibly not yet created)?
+	inline bool hasScene() const { return scene_ || lazy_scene_; }
+	/// was the scene already created?
+	bool sceneMaterialized() const;
+	/// diff of the scene w.r.t. its parent scene as created by the stage, i.e. before interning
+	void getSceneDiffMsg(moveit_msgs::PlanningScene& msg) const;
 	inline const Solutions& incomingTrajectories() const { return incoming_trajectories_; }
 	inline const Solutions& outgoingTrajectories() const { return outgoing_trajectories_; }
 
@@ -121,8 +177,17 @@ private:
 	inline void addIncoming(SolutionBase* t) { incoming_trajectories_.push_back(t); }
 	inline void addOutgoing(SolutionBase* t) { outgoing_trajectories_.push_back(t); }
 
+	// create scene of a lazy state (once for all copies)
+	const planning_scene::PlanningSceneConstPtr& materialize() const;
+
 private:
+	// scene of a non-lazy state (or of a flattened lazy one), lazy states keep their created scene in lazy_scene_
 	planning_scene::PlanningSceneConstPtr scene_;
+	// diff of the original scene w.r.t. its parent, if scene_ replaced it
+	std::shared_ptr<const moveit_msgs::PlanningScene> scene_diff_;
+	// recipe to create scene_ on demand, shared between copies
+	struct LazyScene;
+	std::shared_ptr<LazyScene> lazy_scene_;
 	PropertyMap properties_;
 	Solutions incoming_trajectories_;
 	Solutions outgoing_trajectories_;
@@ -178,8 +243,17 @@ public:
 	/// update state's priority (and call notify_ if it really has changed)
 	void updatePriority(InterfaceState* state, const InterfaceState::Priority& priority);
 
+	/** remove (and return) states exceeding the given cost bound, rejecting such states in future add() calls
+	 *
+	 * Assuming non-negative costs, these states cannot become part of a solution better than bound.
+	 */
+	container_type prune(double bound);
+	/// remove all states and lift the cost bound
+	void clear();
+
 private:
 	const NotifyFunction notify_;
+	double cost_bound_ = std::numeric_limits<double>::infinity();
 
 	// restrict access to some functions to ensure consistency
 	// (we need to set/unset InterfaceState::owner_)
@@ -217,6 +291,8 @@ public:
 		end_ = &state;
 		const_cast<InterfaceState&>(state).addIncoming(this);
 	}
+	/// unlink from start and end state (before discarding the solution)
+	void detachStates();
 
 	inline const StagePrivate* creator() const { return creator_; }
 	void setCreator(StagePrivate* creator);
@@ -232,6 +308,14 @@ public:
 	auto& markers() { return markers_; }
 	const auto& markers() const { return markers_; }
 
+	/// free bulky data (markers, trajectory) of a solution that cannot become part of a relevant solution anymore
+	virtual void release() {
+		std::deque<visualization_msgs::Marker>().swap(markers_);
+		released_ = true;
+	}
+	/// was bulky data released? Such solutions must not be used to compose new ones.
+	inline bool isReleased() const { return released_; }
+
 	/// append this solution to Solution msg
 	virtual void fillMessage(moveit_task_constructor_msgs::Solution& solution,
 	                         Introspection* introspection = nullptr) const = 0;
@@ -253,6 +337,7 @@ private:
 	std::string comment_;
 	// markers for this solution, e.g. target frame or collision indicators
 	std::deque<visualization_msgs::Marker> markers_;
+	bool released_ = false;
 
 	// begin and end InterfaceState of this solution/trajectory
 	const InterfaceState* start_ = nullptr;
@@ -269,14 +354,38 @@ public:
 	    double cost = 0.0, std::string comment = "")
 	  : SolutionBase(nullptr, cost, std::move(comment)), trajectory_(trajectory) {}
 
+	using TimingFunction = std::function<void(robot_trajectory::RobotTrajectory&)>;
+
+	/// trajectory, possibly not yet timed
 	robot_trajectory::RobotTrajectoryConstPtr trajectory() const { return trajectory_; }
-	void setTrajectory(const robot_trajectory::RobotTrajectoryPtr& t) { trajectory_ = t; }
+	void setTrajectory(const robot_trajectory::RobotTrajectoryPtr& t) {
+		trajectory_ = t;
+		timing_.reset();
+	}
+	/** set trajectory, deferring its time parameterization until the solution is actually used
+	 *
+	 * As most candidate solutions are never published nor executed, timing is only computed
+	 * on first access via timedTrajectory(). An empty timing function indicates a timed trajectory.
+	 * The timing is applied to a copy, leaving the trajectory itself untouched.
+	 */
+	void setTrajectory(const robot_trajectory::RobotTrajectoryConstPtr& t, TimingFunction timing);
+	/// trajectory including its (deferred) timing
+	robot_trajectory::RobotTrajectoryConstPtr timedTrajectory() const;
+
+	void release() override {
+		trajectory_.reset();
+		timing_.reset();
+		SolutionBase::release();
+	}
 
 	void fillMessage(moveit_task_constructor_msgs::Solution& msg, Introspection* introspection = nullptr) const override;
 
 private:
 	// actual trajectory, might be empty
 	robot_trajectory::RobotTrajectoryConstPtr trajectory_;
+	// pending time parameterization of trajectory_, shared between copies
+	struct DeferredTiming;
+	std::shared_ptr<DeferredTiming> timing_;
 };
 MOVEIT_CLASS_FORWARD(SubTrajectory)
 
@@ -48,12 +48,18 @@
 
 #include <moveit_msgs/MoveItErrorCodes.h>
 
+#include <future>
+#include <map>
+
 namespace moveit {
 namespace core {
 MOVEIT_CLASS_FORWARD(RobotModel)
 MOVEIT_CLASS_FORWARD(RobotState)
 }
 }
+namespace robot_model_loader {
+MOVEIT_CLASS_FORWARD(RobotModelLoader)
+}
 
 namespace moveit {
 namespace task_constructor {
@@ -117,15 +123,44 @@ public:
 	/// initialize all stages with given scene
 	void init();
 
-	/// reset, init scene (if not yet done), and init all stages, then start planning
-	bool plan(size_t max_solutions = 0);
-	/// interrupt current planning (or execution)
+	/** reset, init scene (if not yet done), and init all stages, then start planning
+	 *
+	 * Without a timeout, planning stops as soon as max_solutions solutions were found (0 = unlimited).
+	 * If a timeout (in seconds) is given, planning is performed in an anytime fashion:
+	 * It continues to improve the found solutions until the wall-clock budget is exhausted,
+	 * with max_solutions denoting the number of best solutions of interest.
+	 * Once these are found, partial solutions exceeding their costs are pruned.
+	 * The remaining time is divided between the stages, limiting their individual timeout().
+	 */
+	bool plan(size_t max_solutions = 0, double timeout = 0.0);
+	/** start planning in a background thread and return immediately
+	 *
+	 * New solutions are reported via the solution callbacks as soon as they are found.
+	 * While planning continues, the best solution found so far is available via bestSolution()
+	 * and can already be passed to execute(). Use preempt() to stop planning early.
+	 * The returned future yields the result of plan().
+	 */
+	std::future<bool> planAsync(size_t max_solutions = 0, double timeout = 0.0);
+	/** keep only the k best solutions while planning (0 = keep all)
+	 *
+	 * Worse top-level solutions are discarded and trajectories and markers of partial solutions,
+	 * which are too costly to contribute to the retained ones, are released. This keeps memory bounded
+	 * in long anytime runs. Retention is never smaller than the max_solutions passed to plan().
+	 */
+	void setSolutionRetention(size_t k);
+	size_t solutionRetention() const;
+	/// interrupt current planning (or execution). Running planners and IK are cancelled cooperatively.
 	void preempt();
 	/// execute solution, return the result
 	moveit_msgs::MoveItErrorCodes execute(const SolutionBase& s);
 
+	/// best top-level solution found so far (or nullptr), safe to call while planning asynchronously
+	SolutionBaseConstPtr bestSolution() const;
+
 	/// print current task state (number of found solutions and propagated states) to std::cout
 	void printState(std::ostream& os = std::cout) const;
+	/// print estimated memory usage of all stages (see Stage::memoryUsage()) to std::cout
+	void printMemoryUsage(std::ostream& os = std::cout) const;
 
 	size_t numSolutions() const { return solutions().size(); }
 	const ordered<SolutionBaseConstPtr>& solutions() const { return stages()->solutions(); }
@@ -152,6 +187,43 @@ protected:
 	void onNewSolution(const SolutionBase& s) override;
 
 private:
+	/// planning loop of plan() and planAsync(), keeping preempt requests issued after preempt_requests
+	bool planLoop(size_t max_solutions, double timeout, size_t preempt_requests);
+};
+
+/** Blueprint to instantiate many independent tasks with the same stage graph
+ *
+ * The stage graph is described by a builder function, which is run for each new instance.
+ * Stages cannot be copied, so the stage tree is not shared: each instance pays the construction
+ * cost of its stages again. Only the robot model (loaded once) and the template's property defaults,
+ * which are applied before running the builder, are shared. To share solvers (and their configuration)
+ * as well, create them once and capture them in the builder. Planning pipelines are shared anyway.
+ */
+class TaskTemplate
+{
+public:
+	using Builder = std::function<void(Task& task)>;
+
+	TaskTemplate(Builder builder, const moveit::core::RobotModelConstPtr& robot_model = nullptr);
+
+	const moveit::core::RobotModelConstPtr& getRobotModel() const { return robot_model_; }
+	void setRobotModel(const moveit::core::RobotModelConstPtr& robot_model) { robot_model_ = robot_model; }
+	/// load robot model from given parameter (once for all instances)
+	void loadRobotModel(const std::string& robot_description = "robot_description");
+
+	/// set default value of a task property for all instances
+	void setProperty(const std::string& name, const boost::any& value) { properties_[name] = value; }
+	inline void setProperty(const std::string& name, const char* value) { setProperty(name, std::string(value)); }
+
+	/// create a new task with the given id, running the builder on it
+	Task instantiate(const std::string& id) const;
+
+private:
+	Builder builder_;
+	moveit::core::RobotModelConstPtr robot_model_;
+	// keep kinematics plugins of loaded robot model alive
+	robot_model_loader::RobotModelLoaderPtr robot_model_loader_;
+	std::map<std::string, boost::any> properties_;
 };
 
 inline std::ostream& operator<<(std::ostream& os, const Task& task) {
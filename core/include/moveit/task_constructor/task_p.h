@@ -41,6 +41,12 @@
 #include <moveit/task_constructor/container_p.h>
 #include <moveit/task_constructor/task.h>
 
+#include <atomic>
+#include <future>
+#include <limits>
+#include <list>
+#include <mutex>
+
 namespace robot_model_loader {
 MOVEIT_CLASS_FORWARD(RobotModelLoader)
 }
@@ -51,12 +57,25 @@ namespace task_constructor {
 class TaskPrivate : public WrapperBasePrivate
 {
 	friend class Task;
+	friend class BatchPlanner;
 
 public:
 	TaskPrivate(Task* me, const std::string& id);
 	const std::string& id() const { return id_; }
 	const ContainerBase* stages() const;
 
+	/// branch-and-bound: prune partial solutions that cannot improve on the k best solutions found so far
+	void pruneDominated(size_t k);
+	/// only keep the k best solutions, releasing data of partial solutions that cannot contribute to them
+	void retainSolutions(size_t k);
+
+	/// reset and init the task, setting up the stopping criteria of plan()
+	void startPlanning(size_t max_solutions, double timeout);
+	/// perform a single planning iteration, returns false when planning is finished
+	bool planStep();
+	/// request preemption of current and pending planning runs
+	void preempt();
+
 protected:
 	static void swap(StagePrivate*& lhs, StagePrivate*& rhs);
 
@@ -64,7 +83,26 @@ private:
 	std::string id_;
 	robot_model_loader::RobotModelLoaderPtr robot_model_loader_;
 	moveit::core::RobotModelConstPtr robot_model_;
-	bool preempt_requested_;
+	std::atomic<bool> preempt_requested_;
+	// number of preempt requests so far: a new planning run keeps the ones issued after its start
+	std::atomic<size_t> preempt_requests_{ 0 };
+	// cost bound used for last pruning
+	double pruning_bound_ = std::numeric_limits<double>::infinity();
+	// stopping criteria of current planning run
+	size_t max_solutions_ = 0;
+	bool anytime_ = false;
+	// number of top-level solutions to keep (0 = all)
+	size_t solution_retention_ = 0;
+	// cost bound used for last release of solutions
+	double retention_bound_ = std::numeric_limits<double>::infinity();
+
+	// held for the whole duration of planning
+	std::mutex planning_mutex_;
+	// background threads launched by planAsync(), awaited on destruction
+	std::list<std::future<void>> async_runs_;
+	std::mutex async_runs_mutex_;
+	// protects stages' solutions and states while planning (possibly in a background thread)
+	mutable std::recursive_mutex compute_mutex_;
 
 	// introspection and monitoring
 	std::unique_ptr<Introspection> introspection_;
@@ -0,0 +1,59 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2026, MoveIt Task Constructor contributors
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of the copyright holder nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+/* Time parameterization of trajectories, which may be deferred until a solution is used */
+
+#pragma once
+
+#include <moveit/macros/class_forward.h>
+
+namespace robot_trajectory {
+MOVEIT_CLASS_FORWARD(RobotTrajectory)
+}
+
+namespace moveit {
+namespace task_constructor {
+
+/// compute time stamps of the trajectory's waypoints, scaling the joints' max velocity and acceleration
+void computeTimeStamps(robot_trajectory::RobotTrajectory& trajectory, double max_velocity_scaling_factor = 1.0,
+                       double max_acceleration_scaling_factor = 1.0);
+
+/** cheap estimate of the trajectory's duration, e.g. for use as cost
+ *
+ * For a timed trajectory, this is its actual duration. For an untimed one,
+ * a lower bound is computed from path length and the joints' velocity limits.
+ */
+double estimateDuration(const robot_trajectory::RobotTrajectory& trajectory, double max_velocity_scaling_factor = 1.0);
+}  // namespace task_constructor
+}  // namespace moveit
@@ -0,0 +1,123 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2026, MoveIt Task Constructor contributors
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of the copyright holder nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+/* Lightweight tracing of planning activity, exported as Chrome trace */
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <ostream>
+#include <string>
+
+namespace moveit {
+namespace task_constructor {
+namespace trace {
+
+/// event types, values correspond to Chrome trace phases
+enum Phase : char
+{
+	BEGIN = 'B',
+	END = 'E',
+	INSTANT = 'i',
+};
+
+/** Tracer records begin/end events into a fixed-size, lock-free ring buffer.
+ *
+ * Tracing is disabled by default and then costs a single atomic load per trace point.
+ * Once the ring buffer is full, the oldest events are overwritten.
+ * The recorded events can be dumped as a Chrome trace (JSON) file, to be viewed
+ * with chrome://tracing or https://ui.perfetto.dev.
+ */
+class Tracer
+{
+public:
+	static Tracer& instance();
+
+	/// start recording into a (cleared) ring buffer of given capacity. Don't call while recording from other threads.
+	void enable(size_t capacity = 1 << 16);
+	/// stop recording, keeping the recorded events
+	void disable();
+	static inline bool enabled() { return enabled_.load(std::memory_order_relaxed); }
+
+	/// record an event (category should be a string literal)
+	void record(Phase phase, const char* category, const char* name);
+
+	/// write recorded events in Chrome trace format
+	void dump(std::ostream& os) const;
+	bool dump(const std::string& filename) const;
+
+private:
+	Tracer() = default;
+	struct Event;
+
+	static std::atomic<bool> enabled_;
+	std::unique_ptr<Event[]> events_;
+	size_t capacity_ = 0;
+	std::atomic<uint64_t> next_{ 0 };
+	std::chrono::steady_clock::time_point start_;
+};
+
+/// RAII helper recording a BEGIN event on construction and an END event on destruction
+class Scope
+{
+public:
+	inline Scope(const char* category, const char* name) : category_(category), name_(name) {
+		if (Tracer::enabled())
+			Tracer::instance().record(BEGIN, category_, name_);
+		else
+			category_ = nullptr;
+	}
+	inline ~Scope() {
+		if (category_)
+			Tracer::instance().record(END, category_, name_);
+	}
+	Scope(const Scope&) = delete;
+	Scope& operator=(const Scope&) = delete;
+
+private:
+	const char* category_;
+	const char* name_;
+};
+
+/// record an instantaneous event
+inline void instant(const char* category, const char* name) {
+	if (Tracer::enabled())
+		Tracer::instance().record(INSTANT, category, name);
+}
+}  // namespace trace
+}  // namespace task_constructor
+}  // namespace moveit
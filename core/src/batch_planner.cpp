@@ -0,0 +1,228 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2026, MoveIt Task Constructor contributors
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of the copyright holder nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+#include <moveit/task_constructor/batch_planner.h>
+#include <moveit/task_constructor/task_p.h>
+#include <moveit/task_constructor/trace.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <condition_variable>
+#include <limits>
+#include <list>
+#include <mutex>
+#include <stdexcept>
+#include <vector>
+
+namespace moveit {
+namespace task_constructor {
+
+class BatchPlannerPrivate
+{
+public:
+	struct Job
+	{
+		Task* task;
+		size_t max_solutions;
+		double timeout;
+		double priority;
+		BatchPlanner::DoneCallback done;
+		std::promise<bool> promise;
+
+		bool started = false;
+		bool running = false;  // currently processed by a worker
+		double virtual_time = 0.0;  // consumed compute time, scaled by 1/priority
+	};
+
+	explicit BatchPlannerPrivate(size_t num_threads);
+	~BatchPlannerPrivate();
+
+	// unfinished job with least virtual time, not being processed by another worker
+	std::list<Job>::iterator selectJob();
+	void work();
+	// perform a single planning iteration of job, returns false if finished
+	static bool step(Job& job);
+	// report result of a finished job (without holding the lock)
+	static void finish(Job& job, const std::exception_ptr& error);
+
+	mutable std::mutex mutex_;
+	std::condition_variable job_available_;
+	std::condition_variable job_finished_;
+	std::list<Job> jobs_;
+	size_t num_finishing_ = 0;  // finished jobs, whose result is being reported
+	bool stop_ = false;
+	std::vector<std::thread> workers_;
+};
+
+BatchPlannerPrivate::BatchPlannerPrivate(size_t num_threads) {
+	for (size_t i = 0, end = std::max<size_t>(num_threads, 1); i != end; ++i)
+		workers_.emplace_back(&BatchPlannerPrivate::work, this);
+}
+
+BatchPlannerPrivate::~BatchPlannerPrivate() {
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		for (Job& job : jobs_)
+			job.task->preempt();
+		stop_ = true;
+	}
+	job_available_.notify_all();
+	for (std::thread& worker : workers_)
+		worker.join();
+}
+
+std::list<BatchPlannerPrivate::Job>::iterator BatchPlannerPrivate::selectJob() {
+	auto best = jobs_.end();
+	for (auto it = jobs_.begin(); it != jobs_.end(); ++it)
+		if (!it->running && (best == jobs_.end() || it->virtual_time < best->virtual_time))
+			best = it;
+	return best;
+}
+
+bool BatchPlannerPrivate::step(Job& job) {
+	TaskPrivate* impl = job.task->pimpl();
+	if (!job.started) {
+		job.started = true;
+		impl->startPlanning(job.max_solutions, job.timeout);
+		return true;
+	}
+	return impl->planStep();
+}
+
+void BatchPlannerPrivate::work() {
+	std::unique_lock<std::mutex> lock(mutex_);
+	while (true) {
+		auto job = jobs_.end();
+		job_available_.wait(lock, [this, &job] {
+			job = selectJob();
+			return job != jobs_.end() || (stop_ && jobs_.empty());
+		});
+		if (job == jobs_.end())
+			return;  // stopped
+
+		job->running = true;
+		lock.unlock();
+
+		bool more = false;
+		std::exception_ptr error;
+		const auto start = std::chrono::steady_clock::now();
+		try {
+			trace::Scope scope("batch", "step");
+			more = step(*job);
+		} catch (...) {
+			error = std::current_exception();
+		}
+		const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+		lock.lock();
+		job->running = false;
+		job->virtual_time += elapsed.count() / job->priority;
+		if (more) {
+			job_available_.notify_one();
+			continue;
+		}
+
+		Job finished = std::move(*job);
+		jobs_.erase(job);
+		++num_finishing_;
+		lock.unlock();
+		finish(finished, error);
+		lock.lock();
+		--num_finishing_;
+		job_finished_.notify_all();
+		job_available_.notify_all();  // workers might wait for all jobs to finish
+	}
+}
+
+void BatchPlannerPrivate::finish(Job& job, const std::exception_ptr& error) {
+	if (error) {
+		job.promise.set_exception(error);
+		return;
+	}
+	bool success = job.task->numSolutions() > 0;
+	try {
+		if (job.done)
+			job.done(*job.task, success);
+	} catch (...) {
+		job.promise.set_exception(std::current_exception());
+		return;
+	}
+	job.promise.set_value(success);
+}
+
+BatchPlanner::BatchPlanner(size_t num_threads) : impl_(new BatchPlannerPrivate(num_threads)) {}
+
+BatchPlanner::~BatchPlanner() = default;
+
+std::future<bool> BatchPlanner::add(Task& task, size_t max_solutions, double timeout, double priority,
+                                    const DoneCallback& done) {
+	if (priority <= 0.0)
+		throw std::invalid_argument("BatchPlanner: priority must be positive");
+
+	std::lock_guard<std::mutex> lock(impl_->mutex_);
+	if (impl_->stop_)
+		throw std::runtime_error("BatchPlanner: already stopped");
+
+	// start with the least virtual time of pending jobs, such that new jobs don't starve others
+	double virtual_time = std::numeric_limits<double>::infinity();
+	for (const auto& job : impl_->jobs_)
+		virtual_time = std::min(virtual_time, job.virtual_time);
+
+	task.pimpl()->preempt_requested_ = false;
+	impl_->jobs_.push_back(BatchPlannerPrivate::Job{ &task, max_solutions, timeout, priority, done, {} });
+	auto& job = impl_->jobs_.back();
+	job.virtual_time = std::isfinite(virtual_time) ? virtual_time : 0.0;
+	std::future<bool> result = job.promise.get_future();
+	impl_->job_available_.notify_one();
+	return result;
+}
+
+size_t BatchPlanner::numPending() const {
+	std::lock_guard<std::mutex> lock(impl_->mutex_);
+	return impl_->jobs_.size();
+}
+
+void BatchPlanner::wait() {
+	std::unique_lock<std::mutex> lock(impl_->mutex_);
+	impl_->job_finished_.wait(lock, [this] { return impl_->jobs_.empty() && impl_->num_finishing_ == 0; });
+}
+
+void BatchPlanner::preempt() {
+	std::lock_guard<std::mutex> lock(impl_->mutex_);
+	for (auto& job : impl_->jobs_)
+		job.task->preempt();
+}
+}  // namespace task_constructor
+}  // namespace moveit
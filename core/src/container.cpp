@@ -35,8 +35,10 @@
 /* Authors: Robert Haschke */
 
 #include <moveit/task_constructor/container_p.h>
+#include <moveit/task_constructor/cancellation.h>
 #include <moveit/task_constructor/introspection.h>
 #include <moveit/task_constructor/merge.h>
+#include <moveit/task_constructor/timing.h>
 #include <moveit/planning_scene/planning_scene.h>
 
 #include <ros/console.h>
@@ -46,7 +48,14 @@
 #include <algorithm>
 #include <boost/range/adaptor/reversed.hpp>
 #include <boost/format.hpp>
+#include <exception>
 #include <functional>
+#include <future>
+#include <iterator>
+#include <limits>
+#include <queue>
+#include <set>
+#include <thread>
 
 using namespace std::placeholders;
 
@@ -102,10 +111,43 @@ bool ContainerBasePrivate::canCompute() const {
 }
 
 void ContainerBasePrivate::compute() {
+	// children inherit our deadline (containers might assign a smaller share of the remaining time)
+	for (const auto& child : children_)
+		child->pimpl()->setDeadline(deadline_);
 	// call the method of the public interface
 	static_cast<ContainerBase*>(me_)->compute();
 }
 
+InterfaceState::Priority ContainerBasePrivate::pendingPriority() const {
+	InterfaceState::Priority result(0, std::numeric_limits<double>::infinity());
+	for (const auto& child : children_)
+		if (child->pimpl()->canCompute())
+			result = std::min(result, child->pimpl()->pendingPriority());
+	return result;
+}
+
+void ContainerBasePrivate::pruneStates(double bound) {
+	// our own interfaces are referenced by internal_to_external_: only prune children
+	for (const auto& child : children_)
+		child->pimpl()->pruneStates(bound);
+}
+
+void ContainerBasePrivate::releaseSolutions(double bound, const std::set<const SolutionBase*>& keep) {
+	StagePrivate::releaseSolutions(bound, keep);
+	for (const auto& child : children_)
+		child->pimpl()->releaseSolutions(bound, keep);
+}
+
+Stage* ContainerBasePrivate::selectChild() const {
+	std::vector<Stage*> ready;
+	for (const auto& child : children_)
+		if (child->pimpl()->canCompute())
+			ready.push_back(child.get());
+	if (ready.empty())
+		return nullptr;
+	return scheduling_policy_->select(ready);
+}
+
 void ContainerBasePrivate::copyState(Interface::iterator external, const InterfacePtr& target, bool updated) {
 	// TODO: update internal's prio from external's new priority
 	if (updated)
@@ -151,8 +193,50 @@ void ContainerBasePrivate::liftSolution(const SolutionBasePtr& solution, const I
 	newSolution(solution);
 }
 
+Stage* RoundRobinScheduling::select(const std::vector<Stage*>& ready) {
+	// choose the first ready child following the last selected one, wrapping around at the end
+	const auto& children = ready.front()->pimpl()->parent()->pimpl()->children();
+	auto last = std::find_if(children.begin(), children.end(),
+	                         [this](const Stage::pointer& child) { return child.get() == last_; });
+	Stage* result = ready.front();
+	if (last != children.end()) {
+		for (auto it = std::next(last); it != children.end(); ++it) {
+			if (std::find(ready.begin(), ready.end(), it->get()) != ready.end()) {
+				result = it->get();
+				break;
+			}
+		}
+	}
+	last_ = result;
+	return result;
+}
+
+Stage* CostGuidedScheduling::select(const std::vector<Stage*>& ready) {
+	return *std::min_element(ready.begin(), ready.end(), [](const Stage* a, const Stage* b) {
+		const InterfaceState::Priority pa = a->pimpl()->pendingPriority();
+		const InterfaceState::Priority pb = b->pimpl()->pendingPriority();
+		if (pa.cost() == pb.cost())
+			return pa.depth() > pb.depth();
+		return pa.cost() < pb.cost();
+	});
+}
+
+Stage* CompletionGuidedScheduling::select(const std::vector<Stage*>& ready) {
+	return *std::min_element(ready.begin(), ready.end(), [](const Stage* a, const Stage* b) {
+		return a->pimpl()->pendingPriority() < b->pimpl()->pendingPriority();
+	});
+}
+
 ContainerBase::ContainerBase(ContainerBasePrivate* impl) : Stage(impl) {}
 
+void ContainerBase::setSchedulingPolicy(const SchedulingPolicyPtr& policy) {
+	pimpl()->scheduling_policy_ = policy;
+}
+
+const SchedulingPolicyPtr& ContainerBase::schedulingPolicy() const {
+	return pimpl()->scheduling_policy_;
+}
+
 size_t ContainerBase::numChildren() const {
 	return pimpl()->children().size();
 }
@@ -231,6 +315,9 @@ void ContainerBase::reset() {
 	for (auto& child : impl->children())
 		child->reset();
 
+	if (impl->scheduling_policy_)
+		impl->scheduling_policy_->reset();
+
 	// clear buffer interfaces
 	impl->pending_backward_->clear();
 	impl->pending_forward_->clear();
@@ -521,12 +608,61 @@ bool SerialContainer::canCompute() const {
 	return false;
 }
 
+namespace {
+// children without solutions block complete solutions: increase their share of time by this factor
+constexpr double BLOCKING_WEIGHT = 2.0;
+}  // namespace
+
+void SerialContainerPrivate::assignDeadline(container_type::const_iterator child) {
+	double remaining = remainingTime();
+	if (std::isinf(remaining))
+		return;
+
+	// children never computed before are assumed to be as slow as the slowest known one
+	double slowest = 0.0;
+	for (const auto& stage : children())
+		slowest = std::max(slowest, stage->pimpl()->averageComputeTime());
+	auto weight = [slowest](const Stage& stage) {
+		double average = stage.pimpl()->averageComputeTime();
+		double expected = average > 0.0 ? average : (slowest > 0.0 ? slowest : 1.0);
+		return stage.solutions().empty() ? BLOCKING_WEIGHT * expected : expected;
+	};
+
+	// children are computed in sequence: evaluating the share at each child's turn, any overrun of
+	// previous children is distributed among the remaining ones instead of starving the last ones
+	double own = weight(**child);
+	double total = own;
+	for (auto it = std::next(child); it != children().end(); ++it)
+		if ((*it)->pimpl()->canCompute())
+			total += weight(**it);
+	auto deadline = std::chrono::steady_clock::now() + std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+	                                                       std::chrono::duration<double>(own / total * remaining));
+	(*child)->pimpl()->setDeadline(std::min(deadline, deadline_));
+}
+
 void SerialContainer::compute() {
-	for (const auto& stage : pimpl()->children()) {
+	if (pimpl()->schedulingPolicy()) {
+		// only compute the child chosen by the policy, inheriting the full remaining time
+		Stage* stage = pimpl()->selectChild();
+		if (!stage)
+			return;
+		try {
+			ROS_DEBUG("Computing stage '%s'", stage->name().c_str());
+			stage->pimpl()->runCompute();
+		} catch (const Property::error& e) {
+			stage->reportPropertyError(e);
+		}
+		return;
+	}
+
+	auto impl = pimpl();
+	for (auto it = impl->children().cbegin(), end = impl->children().cend(); it != end; ++it) {
+		const auto& stage = *it;
 		try {
 			if (!stage->pimpl()->canCompute())
 				continue;
 
+			impl->assignDeadline(it);
 			ROS_DEBUG("Computing stage '%s'", stage->name().c_str());
 			stage->pimpl()->runCompute();
 		} catch (const Property::error& e) {
@@ -699,6 +835,100 @@ void WrapperBase::compute() {
 	}
 }
 
+namespace {
+// compute child, reporting property errors
+void computeChild(Stage* child) {
+	try {
+		child->pimpl()->runCompute();
+	} catch (const Property::error& e) {
+		child->reportPropertyError(e);
+	}
+}
+
+// move all states from source into target interface
+void moveStates(const InterfacePtr& source, const InterfacePtr& target) {
+	if (!source)
+		return;
+	while (!source->empty()) {
+		Interface::container_type removed = source->remove(source->begin());
+		target->add(*removed.front());
+	}
+}
+}  // namespace
+
+void ParallelContainerBasePrivate::computeConcurrently(const std::vector<Stage*>& children) {
+	if (children.empty())
+		return;
+
+	// redirect background children to private interfaces, keeping the shared ones for restoring
+	struct Redirection
+	{
+		StagePrivate* child;
+		InterfacePtr shared_prev_ends, shared_next_starts;
+		InterfacePtr prev_ends, next_starts;
+	};
+	std::vector<Redirection> redirections;
+	for (auto it = std::next(children.begin()); it != children.end(); ++it) {
+		StagePrivate* child = (*it)->pimpl();
+		Redirection r{ child, child->prevEnds(), child->nextStarts(), nullptr, nullptr };
+		if (r.shared_prev_ends)
+			r.prev_ends = std::make_shared<Interface>();
+		if (r.shared_next_starts)
+			r.next_starts = std::make_shared<Interface>();
+		child->setPrevEnds(r.prev_ends);
+		child->setNextStarts(r.next_starts);
+		redirections.push_back(std::move(r));
+	}
+
+	const std::atomic<bool>* cancel = cancellation::current();
+	std::vector<std::future<void>> background;
+	for (auto it = std::next(children.begin()); it != children.end(); ++it)
+		background.push_back(std::async(std::launch::async, [stage = *it, cancel]() {
+			cancellation::Scope scope(cancel);
+			computeChild(stage);
+		}));
+
+	std::exception_ptr error;
+	try {
+		computeChild(children.front());
+	} catch (...) {
+		error = std::current_exception();
+	}
+	for (auto& f : background) {
+		try {
+			f.get();
+		} catch (...) {
+			if (!error)
+				error = std::current_exception();
+		}
+	}
+
+	// publish states of background children on this thread
+	for (const Redirection& r : redirections) {
+		r.child->setPrevEnds(r.shared_prev_ends);
+		r.child->setNextStarts(r.shared_next_starts);
+		moveStates(r.prev_ends, r.shared_prev_ends);
+		moveStates(r.next_starts, r.shared_next_starts);
+	}
+	if (error)
+		std::rethrow_exception(error);
+}
+
+AlternativesPrivate::AlternativesPrivate(Alternatives* me, const std::string& name)
+  : ParallelContainerBasePrivate(me, name) {}
+
+Alternatives::Alternatives(const std::string& name) : Alternatives(new AlternativesPrivate(this, name)) {}
+
+Alternatives::Alternatives(AlternativesPrivate* impl) : ParallelContainerBase(impl) {}
+
+void Alternatives::setConcurrent(bool concurrent) {
+	pimpl()->concurrent_ = concurrent;
+}
+
+bool Alternatives::concurrent() const {
+	return pimpl()->concurrent_;
+}
+
 bool Alternatives::canCompute() const {
 	for (const auto& stage : pimpl()->children())
 		if (stage->pimpl()->canCompute())
@@ -707,55 +937,172 @@ bool Alternatives::canCompute() const {
 }
 
 void Alternatives::compute() {
-	for (const auto& stage : pimpl()->children()) {
-		try {
-			stage->pimpl()->runCompute();
-		} catch (const Property::error& e) {
-			stage->reportPropertyError(e);
-		}
+	auto impl = pimpl();
+	if (impl->schedulingPolicy()) {
+		if (Stage* stage = impl->selectChild())
+			computeChild(stage);
+		return;
 	}
+
+	if (!impl->concurrent_) {
+		for (const auto& stage : impl->children())
+			computeChild(stage.get());
+		return;
+	}
+
+	std::vector<Stage*> ready;
+	for (const auto& stage : impl->children())
+		if (stage->pimpl()->canCompute())
+			ready.push_back(stage.get());
+	if (ready.empty())
+		return;
+
+	impl->collecting_ = true;
+	try {
+		impl->computeConcurrently(ready);
+	} catch (...) {
+		impl->collecting_ = false;
+		impl->collected_.clear();
+		throw;
+	}
+	impl->collecting_ = false;
+
+	// lift in deterministic order: by cost, ties resolved by children order
+	std::vector<const SolutionBase*> solutions;
+	for (const auto& stage : impl->children()) {
+		auto it = impl->collected_.find(stage->pimpl());
+		if (it != impl->collected_.end())
+			solutions.insert(solutions.end(), it->second.begin(), it->second.end());
+	}
+	impl->collected_.clear();
+	std::stable_sort(solutions.begin(), solutions.end(),
+	                 [](const SolutionBase* a, const SolutionBase* b) { return a->cost() < b->cost(); });
+	for (const SolutionBase* s : solutions)
+		liftSolution(*s);
 }
 
 void Alternatives::onNewSolution(const SolutionBase& s) {
+	auto impl = pimpl();
+	if (impl->collecting_) {
+		std::lock_guard<std::mutex> lock(impl->collected_mutex_);
+		impl->collected_[s.creator()].push_back(&s);
+		return;
+	}
 	liftSolution(s);
 }
 
+FallbacksPrivate::FallbacksPrivate(Fallbacks* me, const std::string& name)
+  : ParallelContainerBasePrivate(me, name) {}
+
+void FallbacksPrivate::liftHeldBack(const Stage* child) {
+	std::vector<const SolutionBase*> held_back;
+	{
+		std::lock_guard<std::mutex> lock(held_back_mutex_);
+		auto it = held_back_.find(child->pimpl());
+		if (it != held_back_.end()) {
+			held_back.swap(it->second);
+			held_back_.erase(it);
+		}
+	}
+	for (const SolutionBase* s : held_back)
+		static_cast<Fallbacks*>(me_)->liftSolution(*s);
+}
+
+void FallbacksPrivate::activateNext() {
+	while (active_child_) {
+		// release solutions found while the child was computed speculatively
+		liftHeldBack(active_child_);
+
+		if (active_child_->pimpl()->canCompute())
+			return;
+
+		// active child failed, continue with next
+		auto next = active_child_->pimpl()->it();
+		++next;
+		active_child_ = next == children().end() ? nullptr : next->get();
+	}
+}
+
+Stage* FallbacksPrivate::speculativeChild() const {
+	if (!active_child_)
+		return nullptr;
+	for (auto it = std::next(active_child_->pimpl()->it()); it != children().end(); ++it)
+		if ((*it)->pimpl()->canCompute())
+			return it->get();
+	return nullptr;
+}
+
+bool FallbacksPrivate::hasHeldBack(const Stage* child) const {
+	std::lock_guard<std::mutex> lock(held_back_mutex_);
+	return held_back_.count(child->pimpl()) > 0;
+}
+
+Fallbacks::Fallbacks(const std::string& name) : Fallbacks(new FallbacksPrivate(this, name)) {}
+
+Fallbacks::Fallbacks(FallbacksPrivate* impl) : ParallelContainerBase(impl) {}
+
+void Fallbacks::setSpeculative(bool speculative) {
+	pimpl()->speculative_ = speculative;
+}
+
+bool Fallbacks::speculative() const {
+	return pimpl()->speculative_;
+}
+
 void Fallbacks::reset() {
-	active_child_ = nullptr;
+	auto impl = pimpl();
+	impl->active_child_ = nullptr;
+	impl->held_back_.clear();
 	ParallelContainerBase::reset();
 }
 
 void Fallbacks::init(const moveit::core::RobotModelConstPtr& robot_model) {
 	ParallelContainerBase::init(robot_model);
-	active_child_ = pimpl()->children().front().get();
+	pimpl()->active_child_ = pimpl()->children().front().get();
 }
 
 bool Fallbacks::canCompute() const {
-	while (active_child_) {
-		StagePrivate* child = active_child_->pimpl();
-		if (child->canCompute())
+	auto impl = pimpl();
+	if (!impl->active_child_)
+		return false;
+	// the active child or any later one might still compute or hold back solutions
+	for (auto it = impl->active_child_->pimpl()->it(); it != impl->children().end(); ++it)
+		if ((*it)->pimpl()->canCompute() || impl->hasHeldBack(it->get()))
 			return true;
-
-		// active child failed, continue with next
-		auto next = child->it();
-		++next;
-		active_child_ = next->get();
-	}
 	return false;
 }
 
 void Fallbacks::compute() {
-	if (!active_child_)
+	auto impl = pimpl();
+	impl->activateNext();
+	if (!impl->active_child_)
 		return;
 
+	Stage* speculative = impl->speculative_ ? impl->speculativeChild() : nullptr;
+	if (!speculative)
+		return computeChild(impl->active_child_);
+
+	// compute next fallback concurrently, holding back all solutions until both children finished:
+	// lifting them might trigger pruning of the whole task tree, including the speculative child
+	impl->computing_concurrently_ = true;
 	try {
-		active_child_->pimpl()->runCompute();
-	} catch (const Property::error& e) {
-		active_child_->reportPropertyError(e);
+		impl->computeConcurrently({ impl->active_child_, speculative });
+	} catch (...) {
+		impl->computing_concurrently_ = false;
+		throw;
 	}
+	impl->computing_concurrently_ = false;
+	impl->liftHeldBack(impl->active_child_);
 }
 
 void Fallbacks::onNewSolution(const SolutionBase& s) {
+	auto impl = pimpl();
+	if (impl->computing_concurrently_ ||
+	    (impl->speculative_ && impl->active_child_ && s.creator() != impl->active_child_->pimpl())) {
+		std::lock_guard<std::mutex> lock(impl->held_back_mutex_);
+		impl->held_back_[s.creator()].push_back(&s);
+		return;
+	}
 	liftSolution(s);
 }
 
@@ -784,6 +1131,7 @@ void Merger::reset() {
 	ParallelContainerBase::reset();
 	auto impl = pimpl();
 	impl->jmg_merged_.reset();
+	impl->jmgs_merged_.clear();
 	impl->source_state_to_solutions_.clear();
 }
 
@@ -791,7 +1139,10 @@ void Merger::init(const core::RobotModelConstPtr& robot_model) {
 	ParallelContainerBase::init(robot_model);
 }
 
-Merger::Merger(MergerPrivate* impl) : ParallelContainerBase(impl) {}
+Merger::Merger(MergerPrivate* impl) : ParallelContainerBase(impl) {
+	properties().declare<uint32_t>("max_combinations", 0u,
+	                               "max number of solution combinations merged per new child solution (0: all)");
+}
 
 bool Merger::canCompute() const {
 	for (const auto& stage : pimpl()->children())
@@ -882,74 +1233,146 @@ void MergerPrivate::onNewGeneratorSolution(const SolutionBase& s) {
 	// TODO: implement in similar fashion as onNewPropagateSolution(), but also merge start/end states
 }
 
+std::vector<MergerPrivate::ChildSolutionList>
+MergerPrivate::bestCombinations(const ChildSolutionMap& all_solutions, const SolutionBase& current, size_t max) {
+	// per child, the candidate solutions sorted by cost (current solution is fixed for its creator)
+	std::vector<ChildSolutionList> sorted;
+	sorted.reserve(all_solutions.size());
+	for (const auto& pair : all_solutions) {
+		ChildSolutionList list;
+		if (pair.first == current.creator())
+			list.push_back(static_cast<const SubTrajectory*>(&current));
+		else {
+			std::copy_if(pair.second.begin(), pair.second.end(), std::back_inserter(list),
+			             [](const SubTrajectory* s) { return !s->isFailure() && !s->isReleased(); });
+			std::stable_sort(list.begin(), list.end(),
+			                 [](const SubTrajectory* a, const SubTrajectory* b) { return a->cost() < b->cost(); });
+		}
+		if (list.empty())
+			return {};
+		sorted.push_back(std::move(list));
+	}
+
+	using Indices = std::vector<size_t>;
+	auto cost = [&sorted](const Indices& indices) {
+		double sum = 0.0;
+		for (size_t i = 0; i < indices.size(); ++i)
+			sum += sorted[i][indices[i]]->cost();
+		return sum;
+	};
+	// min-heap of index combinations by summed cost, expanding successors lazily
+	using Entry = std::pair<double, Indices>;
+	std::priority_queue<Entry, std::vector<Entry>, std::greater<Entry>> queue;
+	std::set<Indices> seen;
+	Indices first(sorted.size(), 0);
+	queue.emplace(cost(first), first);
+	seen.insert(first);
+
+	std::vector<ChildSolutionList> result;
+	while (!queue.empty() && (max == 0 || result.size() < max)) {
+		Indices indices = queue.top().second;
+		queue.pop();
+
+		ChildSolutionList combination;
+		combination.reserve(indices.size());
+		for (size_t i = 0; i < indices.size(); ++i)
+			combination.push_back(sorted[i][indices[i]]);
+		result.push_back(std::move(combination));
+
+		for (size_t i = 0; i < indices.size(); ++i) {
+			if (indices[i] + 1 >= sorted[i].size())
+				continue;
+			Indices next = indices;
+			++next[i];
+			if (seen.insert(next).second)
+				queue.emplace(cost(next), std::move(next));
+		}
+	}
+	return result;
+}
+
 void MergerPrivate::mergeAnyCombination(const ChildSolutionMap& all_solutions, const SolutionBase& current,
                                         const planning_scene::PlanningSceneConstPtr& start_scene,
                                         const Spawner& spawner) {
-	std::vector<size_t> indeces;  // which solution index was considered last for i-th child?
-	indeces.reserve(children().size());
-
-	ChildSolutionList sub_solutions;
-	sub_solutions.reserve(children().size());
+	size_t max = me()->properties().get<uint32_t>("max_combinations");
+	std::vector<ChildSolutionList> combinations = bestCombinations(all_solutions, current, max);
+	if (combinations.empty())
+		return;
 
-	// initialize vector of sub solutions
-	for (const auto& pair : all_solutions) {
-		// all children, except current solution's creator, start with zero index
-		indeces.push_back(pair.first != current.creator() ? 0 : pair.second.size() - 1);
-		sub_solutions.push_back(pair.second[indeces.back()]);
-	}
-	while (true) {
-		merge(sub_solutions, start_scene, spawner);
-
-		// compose next combination
-		size_t child = 0;
-		for (auto it = all_solutions.cbegin(), end = all_solutions.cend(); it != end; ++it, ++child) {
-			if (it->first == current.creator())
-				continue;  // skip current solution's child
-			if (++indeces[child] >= it->second.size()) {
-				indeces[child] = 0;  // start over with zero
-				sub_solutions[child] = it->second[indeces[child]];
-				continue;  // and continue with next child
-			}
-			// otherwise, a new solution combination is available
-			sub_solutions[child] = it->second[indeces[child]];
-			break;
-		}
-		if (child == children().size())  // all combinations exhausted?
-			break;
+	std::vector<robot_trajectory::RobotTrajectoryPtr> merged(combinations.size());
+	auto it = combinations.begin();
+	if (!jmg_merged_) {  // first merge creates the merged group, which is reused afterwards
+		moveit::core::JointModelGroup* jmg = nullptr;
+		merged.front() = merge(*it++, start_scene, jmg);
+		adoptMergedGroup(jmg);
 	}
+
+	// merge and validate remaining combinations in parallel, each worker processing every n-th combination
+	const size_t begin = it - combinations.begin();
+	const size_t num_workers =
+	    std::min<size_t>(std::max(1u, std::thread::hardware_concurrency()), combinations.size() - begin);
+	std::vector<moveit::core::JointModelGroup*> jmgs(combinations.size(), jmg_merged_.get());
+	std::vector<std::future<void>> workers;
+	for (size_t w = 0; w < num_workers; ++w)
+		workers.push_back(std::async(std::launch::async, [&, w]() {
+			for (size_t i = begin + w; i < combinations.size(); i += num_workers)
+				merged[i] = merge(combinations[i], start_scene, jmgs[i]);
+		}));
+	for (auto& worker : workers)
+		worker.get();
+	for (size_t i = begin; i < combinations.size(); ++i)
+		if (jmgs[i] != jmg_merged_.get())
+			adoptMergedGroup(jmgs[i]);
+
+	// report in order of summed costs
+	for (size_t i = 0; i < combinations.size(); ++i)
+		if (merged[i])
+			spawn(combinations[i], merged[i], spawner);
 }
 
-void MergerPrivate::merge(const ChildSolutionList& sub_solutions,
-                          const planning_scene::PlanningSceneConstPtr& start_scene, const Spawner& spawner) {
+robot_trajectory::RobotTrajectoryPtr MergerPrivate::merge(const ChildSolutionList& sub_solutions,
+                                                          const planning_scene::PlanningSceneConstPtr& start_scene,
+                                                          moveit::core::JointModelGroup*& jmg) {
 	// transform vector of SubTrajectories into vector of RobotTrajectories
 	std::vector<robot_trajectory::RobotTrajectoryConstPtr> sub_trajectories;
 	sub_trajectories.reserve(sub_solutions.size());
 	for (const auto& sub : sub_solutions) {
-		// TODO: directly skip failures in mergeAnyCombination() or even earlier
-		if (sub->isFailure())
-			return;
+		if (sub->isReleased()) {  // trajectory is gone: merging the others would yield a wrong result
+			ROS_DEBUG_STREAM_NAMED("Merger", "Cannot merge released solution");
+			return robot_trajectory::RobotTrajectoryPtr();
+		}
 		if (sub->trajectory())
 			sub_trajectories.push_back(sub->trajectory());
 	}
 
-	moveit::core::JointModelGroup* jmg = jmg_merged_.get();
 	robot_trajectory::RobotTrajectoryPtr merged;
 	try {
-		merged = task_constructor::merge(sub_trajectories, start_scene->getCurrentState(), jmg);
+		// timing is deferred until the solution is used, see spawn()
+		merged = task_constructor::merge(sub_trajectories, start_scene->getCurrentState(), jmg, false);
 	} catch (const std::runtime_error& e) {
-		ROS_INFO_STREAM_NAMED("Merger", this->name() << "Merging failed: " << e.what());
-		return;
+		ROS_INFO_STREAM_NAMED("Merger", "Merging failed: " << e.what());
+		return merged;
 	}
-	if (jmg_merged_.get() != jmg)
-		jmg_merged_.reset(jmg);
-	if (!merged)
-		return;
 
 	// check merged trajectory for collisions
-	if (!start_scene->isPathValid(*merged))
+	if (merged && !start_scene->isPathValid(*merged))
+		merged.reset();
+	return merged;
+}
+
+void MergerPrivate::adoptMergedGroup(moveit::core::JointModelGroup* jmg) {
+	if (!jmg || jmg == jmg_merged_.get())
 		return;
+	if (jmg_merged_)
+		jmgs_merged_.push_back(jmg_merged_);
+	jmg_merged_.reset(jmg);
+}
 
-	SubTrajectory t(merged);
+void MergerPrivate::spawn(const ChildSolutionList& sub_solutions, const robot_trajectory::RobotTrajectoryPtr& merged,
+                          const Spawner& spawner) {
+	SubTrajectory t;
+	// merged trajectory is timed when used, at full speed
+	t.setTrajectory(merged, [](robot_trajectory::RobotTrajectory& trajectory) { computeTimeStamps(trajectory); });
 	// accumulate costs and markers
 	double costs = 0.0;
 	for (const auto& sub : sub_solutions) {
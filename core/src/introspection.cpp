@@ -47,6 +47,7 @@
 #include <moveit/planning_scene/planning_scene.h>
 
 #include <boost/bimap.hpp>
+#include <mutex>
 
 namespace moveit {
 namespace task_constructor {
@@ -79,6 +80,7 @@ public:
 		stage_to_id_map_[task_] = 0;  // root is task having ID = 0
 
 		id_solution_bimap_.clear();
+		next_solution_id_ = 0;
 	}
 
 	ros::NodeHandle nh_;
@@ -97,6 +99,10 @@ public:
 	/// mapping from stages to their id
 	std::map<const StagePrivate*, moveit_task_constructor_msgs::StageStatistics::_id_type> stage_to_id_map_;
 	boost::bimap<uint32_t, const SolutionBase*> id_solution_bimap_;
+	// ids are never reused, even if solutions are released
+	uint32_t next_solution_id_ = 0;
+	// solutions might be registered concurrently (e.g. by speculative Fallbacks)
+	std::mutex solution_mutex_;
 };
 
 Introspection::Introspection(const TaskPrivate* task) : impl(new IntrospectionPrivate(task)) {
@@ -158,6 +164,7 @@ void Introspection::publishAllSolutions(bool wait) {
 }
 
 const SolutionBase* Introspection::solutionFromId(uint id) const {
+	std::lock_guard<std::mutex> lock(impl->solution_mutex_);
 	auto it = impl->id_solution_bimap_.left.find(id);
 	if (it == impl->id_solution_bimap_.left.end())
 		return nullptr;
@@ -185,8 +192,18 @@ uint32_t Introspection::stageId(const Stage* const s) const {
 }
 
 uint32_t Introspection::solutionId(const SolutionBase& s) {
-	auto result = impl->id_solution_bimap_.left.insert(std::make_pair(1 + impl->id_solution_bimap_.size(), &s));
-	return result.first->first;
+	std::lock_guard<std::mutex> lock(impl->solution_mutex_);
+	auto it = impl->id_solution_bimap_.right.find(&s);
+	if (it != impl->id_solution_bimap_.right.end())
+		return it->second;
+	uint32_t id = ++impl->next_solution_id_;
+	impl->id_solution_bimap_.left.insert(std::make_pair(id, &s));
+	return id;
+}
+
+void Introspection::releaseSolution(const SolutionBase& s) {
+	std::lock_guard<std::mutex> lock(impl->solution_mutex_);
+	impl->id_solution_bimap_.right.erase(&s);
 }
 
 void Introspection::fillStageStatistics(const Stage& stage, moveit_task_constructor_msgs::StageStatistics& s) {
@@ -200,6 +217,21 @@ void Introspection::fillStageStatistics(const Stage& stage, moveit_task_construc
 
 	s.total_compute_time = stage.getTotalComputeTime();
 	s.num_failed = stage.numFailures();
+
+	// compute time distribution and queue depths
+	s.num_computes = stage.numComputeCalls();
+	s.compute_time_p50 = stage.computeTimePercentile(0.5);
+	s.compute_time_p90 = stage.computeTimePercentile(0.9);
+	s.compute_time_p99 = stage.computeTimePercentile(0.99);
+	s.compute_time_max = stage.maxComputeTime();
+	s.max_pending_starts = stage.maxPendingStates(Interface::FORWARD);
+	s.max_pending_ends = stage.maxPendingStates(Interface::BACKWARD);
+
+	const MemoryUsage memory = stage.memoryUsage();
+	s.memory_states = memory.states;
+	s.memory_scenes = memory.scenes;
+	s.memory_trajectories = memory.trajectories;
+	s.memory_markers = memory.markers;
 }
 
 moveit_task_constructor_msgs::TaskDescription&
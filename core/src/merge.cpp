@@ -36,7 +36,7 @@
 /* Authors: Luca Lach, Robert Haschke */
 
 #include <moveit/task_constructor/merge.h>
-#include <moveit/trajectory_processing/iterative_time_parameterization.h>
+#include <moveit/task_constructor/timing.h>
 
 #include <boost/range/adaptor/transformed.hpp>
 #include <boost/algorithm/string/join.hpp>
@@ -107,7 +107,7 @@ moveit::core::JointModelGroup* merge(const std::vector<const moveit::core::Joint
 
 robot_trajectory::RobotTrajectoryPtr
 merge(const std::vector<robot_trajectory::RobotTrajectoryConstPtr>& sub_trajectories,
-      const robot_state::RobotState& base_state, moveit::core::JointModelGroup*& merged_group) {
+      const robot_state::RobotState& base_state, moveit::core::JointModelGroup*& merged_group, bool timing) {
 	if (sub_trajectories.size() <= 1)
 		throw std::runtime_error("Expected multiple sub solutions");
 
@@ -167,8 +167,8 @@ merge(const std::vector<robot_trajectory::RobotTrajectoryConstPtr>& sub_trajecto
 	}
 
 	// add timing
-	trajectory_processing::IterativeParabolicTimeParameterization timing;
-	timing.computeTimeStamps(*merged_traj, 1.0, 1.0);
+	if (timing)
+		computeTimeStamps(*merged_traj);
 	return merged_traj;
 }
 }  // namespace task_constructor
@@ -78,6 +78,10 @@ public:
 		}
 		return it->second;
 	}
+	bool serializable(const std::type_index& type_index) const {
+		auto it = types_.find(type_index);
+		return it != types_.end() && it->second.serialize_ != &PropertySerializerBase::dummySerialize;
+	}
 	const Entry& entry(const std::string& type_name) const {
 		auto it = names_.find(type_name);
 		if (it == names_.end())
@@ -152,6 +156,10 @@ std::string Property::serialize(const boost::any& value) {
 	return REGISTRY_SINGLETON.entry(value.type()).serialize_(value);
 }
 
+bool Property::serializable(const boost::any& value) {
+	return value.empty() || REGISTRY_SINGLETON.serializable(value.type());
+}
+
 boost::any Property::deserialize(const std::string& type_name, const std::string& wire) {
 	if (type_name != Property::typeName(typeid(std::string)) && wire.empty())
 		return boost::any();
@@ -0,0 +1,318 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2026, MoveIt Task Constructor contributors
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of the copyright holder nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+#include <moveit/task_constructor/reachability_map.h>
+#include <moveit/robot_model/robot_model.h>
+#include <moveit/robot_state/robot_state.h>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <limits>
+#include <stdexcept>
+
+namespace moveit {
+namespace task_constructor {
+
+namespace {
+const char MAGIC[4] = { 'M', 'T', 'C', 'R' };
+const uint32_t VERSION = 1;
+const unsigned int NUM_DIRECTIONS = 26;
+
+// unit vectors towards the 26 neighbours of a cube
+const std::array<Eigen::Vector3d, NUM_DIRECTIONS>& directions() {
+	static const std::array<Eigen::Vector3d, NUM_DIRECTIONS> result = [] {
+		std::array<Eigen::Vector3d, NUM_DIRECTIONS> dirs;
+		unsigned int i = 0;
+		for (int x = -1; x <= 1; ++x)
+			for (int y = -1; y <= 1; ++y)
+				for (int z = -1; z <= 1; ++z)
+					if (x || y || z)
+						dirs[i++] = Eigen::Vector3d(x, y, z).normalized();
+		return dirs;
+	}();
+	return result;
+}
+
+// mask of directions adjacent to (and including) each direction
+const std::array<uint32_t, NUM_DIRECTIONS>& adjacentDirections() {
+	static const std::array<uint32_t, NUM_DIRECTIONS> result = [] {
+		std::array<uint32_t, NUM_DIRECTIONS> masks;
+		const auto& dirs = directions();
+		for (unsigned int i = 0; i < NUM_DIRECTIONS; ++i) {
+			masks[i] = 0;
+			for (unsigned int j = 0; j < NUM_DIRECTIONS; ++j)
+				if (dirs[i].dot(dirs[j]) > 0.5)
+					masks[i] |= 1u << j;
+		}
+		return masks;
+	}();
+	return result;
+}
+
+template <typename T>
+void write(std::ostream& os, const T& value) {
+	os.write(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+void write(std::ostream& os, const std::string& value) {
+	write(os, static_cast<uint32_t>(value.size()));
+	os.write(value.data(), value.size());
+}
+
+// sequential reader of the memory-mapped header
+struct Reader
+{
+	const char* pos;
+	const char* end;
+
+	void read(void* dest, size_t size) {
+		if (pos + size > end)
+			throw std::runtime_error("truncated reachability map");
+		std::memcpy(dest, pos, size);
+		pos += size;
+	}
+	template <typename T>
+	T read() {
+		T value;
+		read(&value, sizeof(T));
+		return value;
+	}
+	std::string readString() {
+		std::string result(read<uint32_t>(), '\0');
+		read(&result[0], result.size());
+		return result;
+	}
+};
+}  // namespace
+
+ReachabilityMap::~ReachabilityMap() {
+	if (mapping_)
+		munmap(mapping_, mapping_size_);
+}
+
+unsigned int ReachabilityMap::direction(const Eigen::Vector3d& z) {
+	const auto& dirs = directions();
+	unsigned int best = 0;
+	double best_dot = -2.0;
+	for (unsigned int i = 0; i < NUM_DIRECTIONS; ++i) {
+		double dot = dirs[i].dot(z);
+		if (dot > best_dot) {
+			best_dot = dot;
+			best = i;
+		}
+	}
+	return best;
+}
+
+uint32_t ReachabilityMap::voxel(const Eigen::Vector3d& position) const {
+	size_t index = 0;
+	for (int i = 0; i < 3; ++i) {
+		double cell = std::floor((position[i] - origin_[i]) / resolution_);
+		if (cell < 0 || cell >= dims_[i])
+			return 0;
+		index = index * dims_[i] + static_cast<size_t>(cell);
+	}
+	return masks_[index];
+}
+
+bool ReachabilityMap::reachable(const Eigen::Isometry3d& tip_pose) const {
+	return voxel(tip_pose.translation()) & (1u << direction(tip_pose.linear().col(2)));
+}
+
+unsigned int ReachabilityMap::numDirections(const Eigen::Isometry3d& tip_pose) const {
+	uint32_t mask = voxel(tip_pose.translation());
+	unsigned int count = 0;
+	for (; mask; mask &= mask - 1)
+		++count;
+	return count;
+}
+
+ReachabilityMapPtr ReachabilityMap::compute(const moveit::core::RobotModelConstPtr& robot_model,
+                                            const std::string& group, const std::string& tip, double resolution,
+                                            size_t num_samples) {
+	const moveit::core::JointModelGroup* jmg = robot_model->getJointModelGroup(group);
+	if (!jmg)
+		throw std::runtime_error("unknown group: " + group);
+	const moveit::core::LinkModel* tip_link = robot_model->getLinkModel(tip);
+	if (!tip_link)
+		throw std::runtime_error("unknown link: " + tip);
+	if (resolution <= 0.0)
+		throw std::runtime_error("invalid resolution");
+
+	// group's base link: parent link of the group's root joint
+	const moveit::core::LinkModel* base_link = jmg->getCommonRoot()->getParentLinkModel();
+	if (!base_link)
+		base_link = robot_model->getRootLink();
+
+	// sample tip poses relative to base link
+	std::vector<std::pair<Eigen::Vector3d, unsigned int>> samples;
+	samples.reserve(num_samples);
+	Eigen::Vector3d lower = Eigen::Vector3d::Constant(std::numeric_limits<double>::infinity());
+	Eigen::Vector3d upper = -lower;
+	moveit::core::RobotState state(robot_model);
+	state.setToDefaultValues();
+	for (size_t i = 0; i < num_samples; ++i) {
+		state.setToRandomPositions(jmg);
+		state.update();
+		Eigen::Isometry3d pose =
+		    state.getGlobalLinkTransform(base_link).inverse() * state.getGlobalLinkTransform(tip_link);
+		samples.emplace_back(pose.translation(), direction(pose.linear().col(2)));
+		lower = lower.cwiseMin(pose.translation());
+		upper = upper.cwiseMax(pose.translation());
+	}
+
+	ReachabilityMapPtr map(new ReachabilityMap());
+	map->robot_name_ = robot_model->getName();
+	map->group_ = group;
+	map->base_link_ = base_link->getName();
+	map->tip_ = tip;
+	map->resolution_ = resolution;
+	if (samples.empty())
+		return map;
+
+	// grid covering all samples, padded by one voxel for dilation
+	map->origin_ = lower - Eigen::Vector3d::Constant(resolution);
+	size_t size = 1;
+	for (int i = 0; i < 3; ++i) {
+		map->dims_[i] = static_cast<uint32_t>(std::floor((upper[i] - map->origin_[i]) / resolution)) + 2;
+		size *= map->dims_[i];
+	}
+	std::vector<uint32_t> masks(size, 0);
+	const auto& adjacent = adjacentDirections();
+	auto index = [&map](const Eigen::Vector3d& position, int* cell) {
+		for (int i = 0; i < 3; ++i)
+			cell[i] = static_cast<int>(std::floor((position[i] - map->origin_[i]) / map->resolution_));
+	};
+	for (const auto& sample : samples) {
+		int cell[3];
+		index(sample.first, cell);
+		masks[(cell[0] * map->dims_[1] + cell[1]) * map->dims_[2] + cell[2]] |= adjacent[sample.second];
+	}
+
+	// dilate by one voxel in position to account for discretization
+	map->owned_masks_.assign(size, 0);
+	const int dx = map->dims_[0], dy = map->dims_[1], dz = map->dims_[2];
+	for (int x = 0; x < dx; ++x)
+		for (int y = 0; y < dy; ++y)
+			for (int z = 0; z < dz; ++z) {
+				uint32_t mask = masks[(x * dy + y) * dz + z];
+				if (!mask)
+					continue;
+				for (int nx = std::max(x - 1, 0); nx <= std::min(x + 1, dx - 1); ++nx)
+					for (int ny = std::max(y - 1, 0); ny <= std::min(y + 1, dy - 1); ++ny)
+						for (int nz = std::max(z - 1, 0); nz <= std::min(z + 1, dz - 1); ++nz)
+							map->owned_masks_[(nx * dy + ny) * dz + nz] |= mask;
+			}
+	map->masks_ = map->owned_masks_.data();
+	return map;
+}
+
+void ReachabilityMap::save(const std::string& filename) const {
+	std::ofstream os(filename, std::ios::binary);
+	if (!os)
+		throw std::runtime_error("failed to open " + filename);
+
+	os.write(MAGIC, sizeof(MAGIC));
+	write(os, VERSION);
+	write(os, robot_name_);
+	write(os, group_);
+	write(os, base_link_);
+	write(os, tip_);
+	write(os, resolution_);
+	for (int i = 0; i < 3; ++i)
+		write(os, origin_[i]);
+	for (int i = 0; i < 3; ++i)
+		write(os, dims_[i]);
+
+	// align voxel data for direct access after memory-mapping
+	while (os.tellp() % sizeof(uint32_t))
+		os.put('\0');
+	const size_t size = static_cast<size_t>(dims_[0]) * dims_[1] * dims_[2];
+	os.write(reinterpret_cast<const char*>(masks_), size * sizeof(uint32_t));
+	if (!os)
+		throw std::runtime_error("failed to write " + filename);
+}
+
+ReachabilityMapConstPtr ReachabilityMap::load(const std::string& filename) {
+	int fd = open(filename.c_str(), O_RDONLY);
+	if (fd < 0)
+		throw std::runtime_error("failed to open " + filename);
+	struct stat info;
+	if (fstat(fd, &info) != 0) {
+		close(fd);
+		throw std::runtime_error("failed to stat " + filename);
+	}
+	const size_t file_size = info.st_size;
+	void* data = file_size ? mmap(nullptr, file_size, PROT_READ, MAP_PRIVATE, fd, 0) : MAP_FAILED;
+	close(fd);  // mapping stays valid
+	if (data == MAP_FAILED)
+		throw std::runtime_error("failed to map " + filename);
+
+	ReachabilityMapPtr map(new ReachabilityMap());
+	map->mapping_ = data;  // unmapped by destructor, also on errors below
+	map->mapping_size_ = file_size;
+
+	const char* begin = static_cast<const char*>(data);
+	Reader reader{ begin, begin + file_size };
+	char magic[sizeof(MAGIC)];
+	reader.read(magic, sizeof(magic));
+	if (std::memcmp(magic, MAGIC, sizeof(MAGIC)) != 0 || reader.read<uint32_t>() != VERSION)
+		throw std::runtime_error("invalid reachability map: " + filename);
+	map->robot_name_ = reader.readString();
+	map->group_ = reader.readString();
+	map->base_link_ = reader.readString();
+	map->tip_ = reader.readString();
+	map->resolution_ = reader.read<double>();
+	for (int i = 0; i < 3; ++i)
+		map->origin_[i] = reader.read<double>();
+	for (int i = 0; i < 3; ++i)
+		map->dims_[i] = reader.read<uint32_t>();
+
+	size_t offset = reader.pos - begin;
+	offset += (sizeof(uint32_t) - offset % sizeof(uint32_t)) % sizeof(uint32_t);
+	const size_t size = static_cast<size_t>(map->dims_[0]) * map->dims_[1] * map->dims_[2];
+	if (map->resolution_ <= 0.0 || offset + size * sizeof(uint32_t) > file_size)
+		throw std::runtime_error("truncated reachability map: " + filename);
+	map->masks_ = reinterpret_cast<const uint32_t*>(begin + offset);
+	return map;
+}
+}  // namespace task_constructor
+}  // namespace moveit
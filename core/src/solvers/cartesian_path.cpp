@@ -37,8 +37,9 @@
 */
 
 #include <moveit/task_constructor/solvers/cartesian_path.h>
+#include <moveit/task_constructor/cancellation.h>
+#include <moveit/task_constructor/trace.h>
 #include <moveit/planning_scene/planning_scene.h>
-#include <moveit/trajectory_processing/iterative_time_parameterization.h>
 #if MOVEIT_MASTER
 #include <moveit/robot_state/cartesian_interpolator.h>
 #endif
@@ -74,6 +75,7 @@ bool CartesianPath::plan(const planning_scene::PlanningSceneConstPtr& from, cons
                          const Eigen::Isometry3d& target, const moveit::core::JointModelGroup* jmg, double timeout,
                          robot_trajectory::RobotTrajectoryPtr& result,
                          const moveit_msgs::Constraints& path_constraints) {
+	trace::Scope scope("planner", "CartesianPath");
 	const auto& props = properties();
 	planning_scene::PlanningScenePtr sandbox_scene = from->diff();
 
@@ -82,6 +84,8 @@ bool CartesianPath::plan(const planning_scene::PlanningSceneConstPtr& from, cons
 
 	auto is_valid = [&sandbox_scene, &kcs](moveit::core::RobotState* state, const moveit::core::JointModelGroup* jmg,
 	                                       const double* joint_positions) {
+		if (cancellation::requested())
+			return false;  // stop path computation
 		state->setJointGroupPositions(jmg, joint_positions);
 		state->update();
 		return !sandbox_scene->isStateColliding(const_cast<const robot_state::RobotState&>(*state), jmg->getName()) &&
@@ -105,9 +109,9 @@ bool CartesianPath::plan(const planning_scene::PlanningSceneConstPtr& from, cons
 		for (const auto& waypoint : trajectory)
 			result->addSuffixWayPoint(waypoint, 0.0);
 
-		trajectory_processing::IterativeParabolicTimeParameterization timing;
-		timing.computeTimeStamps(*result, props.get<double>("max_velocity_scaling_factor"),
-		                         props.get<double>("max_acceleration_scaling_factor"));
+		// add timing, unless deferred until the solution is used (see deferredTiming())
+		if (!props.get<bool>("lazy_timing"))
+			computeTimeStamps(*result);
 	}
 
 	return achieved_fraction >= props.get<double>("min_fraction");
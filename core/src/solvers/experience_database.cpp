@@ -0,0 +1,264 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2026, MoveIt Task Constructor contributors
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of the copyright holder nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+/* database of previously planned trajectories to retrieve and repair */
+
+#include <moveit/task_constructor/solvers/experience_database.h>
+#include <moveit/planning_scene/planning_scene.h>
+#include <moveit/robot_trajectory/robot_trajectory.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <limits>
+
+namespace moveit {
+namespace task_constructor {
+namespace solvers {
+
+namespace {
+const char MAGIC[4] = { 'M', 'T', 'C', 'X' };
+const uint32_t VERSION = 1;
+
+template <typename T>
+void write(std::ostream& os, const T& value) {
+	os.write(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+template <typename T>
+bool read(std::istream& is, T& value) {
+	return static_cast<bool>(is.read(reinterpret_cast<char*>(&value), sizeof(T)));
+}
+}  // namespace
+
+ExperienceDatabase::ExperienceDatabase(double resolution) : resolution_(resolution) {}
+
+ExperienceDatabase::Cell ExperienceDatabase::cell(const std::vector<double>& start,
+                                                  const std::vector<double>& goal) const {
+	Cell result;
+	result.reserve(start.size() + goal.size());
+	for (const std::vector<double>* positions : { &start, &goal })
+		for (double p : *positions)
+			result.push_back(static_cast<int64_t>(std::floor(p / resolution_)));
+	return result;
+}
+
+void ExperienceDatabase::add(const robot_trajectory::RobotTrajectory& trajectory) {
+	const moveit::core::JointModelGroup* jmg = trajectory.getGroup();
+	if (!jmg || trajectory.empty())
+		return;
+	Path path(trajectory.getWayPointCount());
+	for (size_t i = 0; i < path.size(); ++i)
+		trajectory.getWayPoint(i).copyJointGroupPositions(jmg, path[i]);
+	add(jmg->getName(), std::move(path));
+}
+
+void ExperienceDatabase::add(const std::string& group, Path&& path) {
+	std::lock_guard<std::mutex> lock(mutex_);
+	std::vector<Path>& stored = paths_[group][cell(path.front(), path.back())];
+	if (capacity_per_cell_ > 0 && stored.size() >= capacity_per_cell_)
+		stored.erase(stored.begin(), stored.begin() + (stored.size() - capacity_per_cell_ + 1));
+	stored.push_back(std::move(path));
+}
+
+bool ExperienceDatabase::retrieve(const planning_scene::PlanningSceneConstPtr& from,
+                                  const planning_scene::PlanningSceneConstPtr& to,
+                                  const moveit::core::JointModelGroup* jmg,
+                                  const moveit_msgs::Constraints& path_constraints, const PlanFunction& repair,
+                                  robot_trajectory::RobotTrajectoryPtr& result) {
+	std::vector<double> start, goal;
+	from->getCurrentState().copyJointGroupPositions(jmg, start);
+	to->getCurrentState().copyJointGroupPositions(jmg, goal);
+
+	// nearest stored path of the same or neighboring cells: queries close to a cell border
+	// should find paths stored on the other side as well
+	Path path;
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		auto group_it = paths_.find(jmg->getName());
+		if (group_it == paths_.end())
+			return false;
+		const Cell query = cell(start, goal);
+		auto neighboring = [&query](const Cell& other) {
+			return std::equal(query.begin(), query.end(), other.begin(),
+			                  [](int64_t a, int64_t b) { return std::abs(a - b) <= 1; });
+		};
+		double best = std::numeric_limits<double>::infinity();
+		for (const auto& pair : group_it->second) {
+			if (pair.first.size() != query.size() || !neighboring(pair.first))
+				continue;
+			for (const Path& candidate : pair.second) {
+				double d = jmg->distance(start.data(), candidate.front().data()) +
+				           jmg->distance(goal.data(), candidate.back().data());
+				if (d < best) {
+					best = d;
+					path = candidate;
+				}
+			}
+		}
+	}
+	if (path.empty())
+		return false;
+	path.front() = start;
+	path.back() = goal;
+
+	moveit::core::RobotState state(from->getCurrentState());
+	auto is_valid = [&](const std::vector<double>& positions) {
+		state.setJointGroupPositions(jmg, positions);
+		state.update();
+		return from->isStateValid(state, path_constraints, jmg->getName());
+	};
+	std::vector<double> waypoint(start.size());
+	auto is_motion_valid = [&](const std::vector<double>& a, const std::vector<double>& b) {
+		const size_t steps = std::ceil(jmg->distance(a.data(), b.data()) / max_step_);
+		for (size_t i = 1; i < steps; ++i) {
+			jmg->interpolate(a.data(), b.data(), static_cast<double>(i) / steps, waypoint.data());
+			if (!is_valid(waypoint))
+				return false;
+		}
+		return is_valid(b);
+	};
+	auto scene_at = [&](const std::vector<double>& positions) {
+		planning_scene::PlanningScenePtr scene = from->diff();
+		scene->getCurrentStateNonConst().setJointGroupPositions(jmg, positions);
+		scene->getCurrentStateNonConst().update();
+		return scene;
+	};
+
+	// the pipeline's request adapters would need to fix such a start state: leave it to the planner
+	if (!from->getCurrentState().satisfiesBounds(jmg) || !is_valid(start))
+		return false;
+	Path repaired{ start };
+	bool was_repaired = false;
+	for (size_t i = 0; i + 1 < path.size();) {
+		if (is_motion_valid(path[i], path[i + 1])) {
+			repaired.push_back(path[++i]);
+			continue;
+		}
+		// replan from last valid waypoint to next valid one
+		size_t j = i + 1;
+		while (j < path.size() && !is_valid(path[j]))
+			++j;
+		robot_trajectory::RobotTrajectoryPtr segment;
+		if (j == path.size() || !repair || !repair(scene_at(path[i]), scene_at(path[j]), segment) || !segment)
+			return false;
+		for (size_t k = 1; k + 1 < segment->getWayPointCount(); ++k) {
+			segment->getWayPoint(k).copyJointGroupPositions(jmg, waypoint);
+			repaired.push_back(waypoint);
+		}
+		repaired.push_back(path[j]);
+		was_repaired = true;
+		i = j;
+	}
+
+	result = std::make_shared<robot_trajectory::RobotTrajectory>(from->getRobotModel(), jmg);
+	state = from->getCurrentState();
+	for (const auto& positions : repaired) {
+		state.setJointGroupPositions(jmg, positions);
+		result->addSuffixWayPoint(state, 0.0);
+	}
+	// exactly reach goal state
+	result->getLastWayPointPtr()->setVariablePositions(to->getCurrentState().getVariablePositions());
+
+	if (was_repaired)
+		add(jmg->getName(), std::move(repaired));
+
+	std::lock_guard<std::mutex> lock(mutex_);
+	++num_hits_;
+	num_repairs_ += was_repaired;
+	return true;
+}
+
+size_t ExperienceDatabase::size() const {
+	std::lock_guard<std::mutex> lock(mutex_);
+	size_t result = 0;
+	for (const auto& group : paths_)
+		for (const auto& pair : group.second)
+			result += pair.second.size();
+	return result;
+}
+
+void ExperienceDatabase::clear() {
+	std::lock_guard<std::mutex> lock(mutex_);
+	paths_.clear();
+}
+
+bool ExperienceDatabase::save(const std::string& filename) const {
+	std::ofstream os(filename, std::ios::binary | std::ios::trunc);
+	if (!os)
+		return false;
+	os.write(MAGIC, sizeof(MAGIC));
+	write(os, VERSION);
+
+	std::lock_guard<std::mutex> lock(mutex_);
+	for (const auto& group_paths : paths_) {
+		const std::string& group = group_paths.first;
+		for (const auto& pair : group_paths.second)
+			for (const Path& path : pair.second) {
+				write<uint32_t>(os, group.size());
+				os.write(group.data(), group.size());
+				write<uint32_t>(os, path.size());
+				write<uint32_t>(os, path.front().size());
+				for (const auto& positions : path)
+					os.write(reinterpret_cast<const char*>(positions.data()), positions.size() * sizeof(double));
+			}
+	}
+	return static_cast<bool>(os);
+}
+
+bool ExperienceDatabase::load(const std::string& filename) {
+	std::ifstream is(filename, std::ios::binary);
+	char magic[sizeof(MAGIC)];
+	uint32_t version;
+	if (!is.read(magic, sizeof(magic)) || !std::equal(magic, magic + sizeof(magic), MAGIC) || !read(is, version) ||
+	    version != VERSION)
+		return false;
+
+	uint32_t group_size, num_waypoints, dimension;
+	while (read(is, group_size)) {
+		std::string group(group_size, '\0');
+		if (!is.read(&group[0], group_size) || !read(is, num_waypoints) || !read(is, dimension) || num_waypoints == 0)
+			return false;
+		Path path(num_waypoints, std::vector<double>(dimension));
+		for (auto& positions : path)
+			if (!is.read(reinterpret_cast<char*>(positions.data()), dimension * sizeof(double)))
+				return false;
+		add(group, std::move(path));
+	}
+	return is.eof();
+}
+}  // namespace solvers
+}  // namespace task_constructor
+}  // namespace moveit
@@ -37,8 +37,9 @@
 */
 
 #include <moveit/task_constructor/solvers/joint_interpolation.h>
+#include <moveit/task_constructor/cancellation.h>
+#include <moveit/task_constructor/trace.h>
 #include <moveit/planning_scene/planning_scene.h>
-#include <moveit/trajectory_processing/iterative_time_parameterization.h>
 
 namespace moveit {
 namespace task_constructor {
@@ -56,6 +57,9 @@ bool JointInterpolationPlanner::plan(const planning_scene::PlanningSceneConstPtr
                                      const moveit::core::JointModelGroup* jmg, double timeout,
                                      robot_trajectory::RobotTrajectoryPtr& result,
                                      const moveit_msgs::Constraints& path_constraints) {
+	trace::Scope scope("planner", "JointInterpolationPlanner");
+	if (cancellation::requested())
+		return false;
 	const auto& props = properties();
 
 	// Get maximum joint distance
@@ -87,10 +91,9 @@ bool JointInterpolationPlanner::plan(const planning_scene::PlanningSceneConstPtr
 	if (from->isStateColliding(to_state, jmg->getName()))
 		return false;
 
-	// add timing, TODO: use a generic method to add timing via plugins
-	trajectory_processing::IterativeParabolicTimeParameterization timing;
-	timing.computeTimeStamps(*result, props.get<double>("max_velocity_scaling_factor"),
-	                         props.get<double>("max_acceleration_scaling_factor"));
+	// add timing, unless deferred until the solution is used (see deferredTiming())
+	if (!props.get<bool>("lazy_timing"))
+		computeTimeStamps(*result);
 
 	return true;
 }
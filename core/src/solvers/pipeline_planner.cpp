@@ -38,12 +38,20 @@
 
 #include <moveit/task_constructor/solvers/pipeline_planner.h>
 #include <moveit/task_constructor/task.h>
+#include <moveit/task_constructor/cancellation.h>
+#include <moveit/task_constructor/trace.h>
 #include <moveit/planning_scene/planning_scene.h>
 #include <moveit/planning_pipeline/planning_pipeline.h>
 #include <moveit_msgs/MotionPlanRequest.h>
 #include <moveit/kinematic_constraints/utils.h>
 #include <eigen_conversions/eigen_msg.h>
 
+#include <chrono>
+#include <condition_variable>
+#include <limits>
+#include <mutex>
+#include <thread>
+
 namespace moveit {
 namespace task_constructor {
 namespace solvers {
@@ -96,10 +104,83 @@ void initMotionPlanRequest(moveit_msgs::MotionPlanRequest& req, const PropertyMa
 	req.workspace_parameters = p.get<moveit_msgs::WorkspaceParameters>("workspace_parameters");
 }
 
+std::function<void(robot_trajectory::RobotTrajectory&)> PipelinePlanner::deferredTiming() const {
+	return nullptr;  // the pipeline's request adapters already compute timing
+}
+
+const void* PipelinePlanner::concurrencyKey() const {
+	return planner_ ? static_cast<const void*>(planner_.get()) : this;
+}
+
 bool PipelinePlanner::plan(const planning_scene::PlanningSceneConstPtr& from,
                            const planning_scene::PlanningSceneConstPtr& to, const moveit::core::JointModelGroup* jmg,
                            double timeout, robot_trajectory::RobotTrajectoryPtr& result,
                            const moveit_msgs::Constraints& path_constraints) {
+	trace::Scope scope("planner", "PipelinePlanner");
+	// don't start when already cancelled
+	if (cancellation::requested())
+		return false;
+	if (!experience_)
+		return planPipeline(from, to, jmg, timeout, result, path_constraints);
+
+	const auto start_time = std::chrono::steady_clock::now();
+	auto remaining = [&]() {
+		return timeout - std::chrono::duration<double>(std::chrono::steady_clock::now() - start_time).count();
+	};
+	// the pipeline interprets a zero timeout as its default: fail instead if no time is left
+	auto repair = [&](const planning_scene::PlanningSceneConstPtr& segment_from,
+	                  const planning_scene::PlanningSceneConstPtr& segment_to,
+	                  robot_trajectory::RobotTrajectoryPtr& segment) {
+		const double time_left = remaining();
+		return time_left > 0.0 && planPipeline(segment_from, segment_to, jmg, time_left, segment, path_constraints);
+	};
+	if (experience_->retrieve(from, to, jmg, path_constraints, repair, result)) {
+		// retrieved paths bypass the request adapters: time them with the scaling passed to the pipeline
+		computeTimeStamps(*result);
+		return true;
+	}
+
+	// miss: plan from scratch
+	const double time_left = remaining();
+	if (time_left <= 0.0 || !planPipeline(from, to, jmg, time_left, result, path_constraints))
+		return false;
+	experience_->add(*result);
+	return true;
+}
+
+bool PipelinePlanner::generatePlan(const planning_scene::PlanningSceneConstPtr& from,
+                                   const moveit_msgs::MotionPlanRequest& req,
+                                   ::planning_interface::MotionPlanResponse& res) {
+	const std::atomic<bool>* cancelled = cancellation::current();
+	if (!cancelled)
+		return planner_->generatePlan(from, req, res);
+
+	// the pipeline doesn't poll for cancellation: terminate it from a watcher thread
+	std::mutex mutex;
+	std::condition_variable finished_cv;
+	bool finished = false;
+	std::thread watcher([&]() {
+		std::unique_lock<std::mutex> lock(mutex);
+		// keep terminating: the planning context might not exist yet on first attempt
+		while (!finished_cv.wait_for(lock, std::chrono::milliseconds(10), [&finished]() { return finished; }))
+			if (cancelled->load(std::memory_order_relaxed))
+				planner_->terminate();
+	});
+	bool success = planner_->generatePlan(from, req, res);
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		finished = true;
+	}
+	finished_cv.notify_one();
+	watcher.join();
+	return success && !cancelled->load(std::memory_order_relaxed);
+}
+
+bool PipelinePlanner::planPipeline(const planning_scene::PlanningSceneConstPtr& from,
+                                   const planning_scene::PlanningSceneConstPtr& to,
+                                   const moveit::core::JointModelGroup* jmg, double timeout,
+                                   robot_trajectory::RobotTrajectoryPtr& result,
+                                   const moveit_msgs::Constraints& path_constraints) {
 	const auto& props = properties();
 	moveit_msgs::MotionPlanRequest req;
 	initMotionPlanRequest(req, props, jmg, timeout);
@@ -110,15 +191,77 @@ bool PipelinePlanner::plan(const planning_scene::PlanningSceneConstPtr& from,
 	req.path_constraints = path_constraints;
 
 	::planning_interface::MotionPlanResponse res;
-	bool success = planner_->generatePlan(from, req, res);
+	bool success = generatePlan(from, req, res);
 	result = res.trajectory_;
 	return success;
 }
 
+bool PipelinePlanner::plan(const planning_scene::PlanningSceneConstPtr& from,
+                           const std::vector<planning_scene::PlanningSceneConstPtr>& to,
+                           const moveit::core::JointModelGroup* jmg, double timeout,
+                           robot_trajectory::RobotTrajectoryPtr& result, size_t& reached,
+                           const moveit_msgs::Constraints& path_constraints) {
+	if (to.size() == 1) {
+		reached = 0;
+		return plan(from, to.front(), jmg, timeout, result, path_constraints);
+	}
+	trace::Scope scope("planner", "PipelinePlanner");
+	// don't start when already cancelled
+	if (cancellation::requested())
+		return false;
+
+	// previous experience reaching any goal without repair?
+	const auto start_time = std::chrono::steady_clock::now();
+	if (experience_) {
+		for (reached = 0; reached < to.size(); ++reached)
+			if (experience_->retrieve(from, to[reached], jmg, path_constraints, nullptr, result)) {
+				computeTimeStamps(*result);
+				return true;
+			}
+		timeout -= std::chrono::duration<double>(std::chrono::steady_clock::now() - start_time).count();
+		if (timeout <= 0.0)
+			return false;
+	}
+
+	const auto& props = properties();
+	moveit_msgs::MotionPlanRequest req;
+	initMotionPlanRequest(req, props, jmg, timeout);
+	for (const auto& goal : to)
+		req.goal_constraints.push_back(kinematic_constraints::constructGoalConstraints(
+		    goal->getCurrentState(), jmg, props.get<double>("goal_joint_tolerance")));
+	req.path_constraints = path_constraints;
+
+	::planning_interface::MotionPlanResponse res;
+	bool success = generatePlan(from, req, res);
+	result = res.trajectory_;
+	if (!success || !result || result->empty())
+		return false;
+
+	// map trajectory back to the goal actually reached
+	std::vector<double> reached_positions, goal_positions;
+	result->getLastWayPoint().copyJointGroupPositions(jmg, reached_positions);
+	double min_distance = std::numeric_limits<double>::infinity();
+	for (size_t i = 0; i < to.size(); ++i) {
+		to[i]->getCurrentState().copyJointGroupPositions(jmg, goal_positions);
+		double distance = jmg->distance(reached_positions.data(), goal_positions.data());
+		if (distance < min_distance) {
+			min_distance = distance;
+			reached = i;
+		}
+	}
+	if (experience_)
+		experience_->add(*result);
+	return true;
+}
+
 bool PipelinePlanner::plan(const planning_scene::PlanningSceneConstPtr& from, const moveit::core::LinkModel& link,
                            const Eigen::Isometry3d& target_eigen, const moveit::core::JointModelGroup* jmg,
                            double timeout, robot_trajectory::RobotTrajectoryPtr& result,
                            const moveit_msgs::Constraints& path_constraints) {
+	trace::Scope scope("planner", "PipelinePlanner");
+	// don't start when already cancelled
+	if (cancellation::requested())
+		return false;
 	const auto& props = properties();
 	moveit_msgs::MotionPlanRequest req;
 	initMotionPlanRequest(req, props, jmg, timeout);
@@ -134,7 +277,7 @@ bool PipelinePlanner::plan(const planning_scene::PlanningSceneConstPtr& from, co
 	req.path_constraints = path_constraints;
 
 	::planning_interface::MotionPlanResponse res;
-	bool success = planner_->generatePlan(from, req, res);
+	bool success = generatePlan(from, req, res);
 	result = res.trajectory_;
 	return success;
 }
@@ -37,6 +37,9 @@
 */
 
 #include <moveit/task_constructor/solvers/planner_interface.h>
+#include <moveit/task_constructor/timing.h>
+
+#include <chrono>
 
 namespace moveit {
 namespace task_constructor {
@@ -46,6 +49,44 @@ PlannerInterface::PlannerInterface() {
 	auto& p = properties();
 	p.declare<double>("max_velocity_scaling_factor", 1.0, "scale down max velocity by this factor");
 	p.declare<double>("max_acceleration_scaling_factor", 1.0, "scale down max acceleration by this factor");
+	p.declare<bool>("lazy_timing", true, "defer time parameterization until a solution is used");
+}
+
+void PlannerInterface::computeTimeStamps(robot_trajectory::RobotTrajectory& trajectory) const {
+	task_constructor::computeTimeStamps(trajectory, properties_.get<double>("max_velocity_scaling_factor"),
+	                                    properties_.get<double>("max_acceleration_scaling_factor"));
+}
+
+bool PlannerInterface::plan(const planning_scene::PlanningSceneConstPtr& from,
+                            const std::vector<planning_scene::PlanningSceneConstPtr>& to,
+                            const moveit::core::JointModelGroup* jmg, double timeout,
+                            robot_trajectory::RobotTrajectoryPtr& result, size_t& reached,
+                            const moveit_msgs::Constraints& path_constraints) {
+	const auto start_time = std::chrono::steady_clock::now();
+	for (reached = 0; reached < to.size(); ++reached) {
+		double remaining =
+		    timeout - std::chrono::duration<double>(std::chrono::steady_clock::now() - start_time).count();
+		if (reached > 0 && remaining <= 0.0)
+			break;
+		if (plan(from, to[reached], jmg, remaining, result, path_constraints))
+			return true;
+	}
+	return false;
+}
+
+double PlannerInterface::estimateDuration(const robot_trajectory::RobotTrajectory& trajectory) const {
+	return task_constructor::estimateDuration(trajectory, properties_.get<double>("max_velocity_scaling_factor"));
+}
+
+std::function<void(robot_trajectory::RobotTrajectory&)> PlannerInterface::deferredTiming() const {
+	if (!properties_.get<bool>("lazy_timing"))
+		return nullptr;
+	// capture current scaling factors, the planner might not outlive the solution
+	const double velocity = properties_.get<double>("max_velocity_scaling_factor");
+	const double acceleration = properties_.get<double>("max_acceleration_scaling_factor");
+	return [velocity, acceleration](robot_trajectory::RobotTrajectory& trajectory) {
+		task_constructor::computeTimeStamps(trajectory, velocity, acceleration);
+	};
 }
 }
 }
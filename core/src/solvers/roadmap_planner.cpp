@@ -0,0 +1,367 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2026, MoveIt Task Constructor contributors
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of the copyright holder nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+/* plan using a persistent, lazily validated roadmap */
+
+#include <moveit/task_constructor/solvers/roadmap_planner.h>
+#include <moveit/task_constructor/cancellation.h>
+#include <moveit/task_constructor/stage_p.h>
+#include <moveit/task_constructor/trace.h>
+#include <moveit/planning_scene/planning_scene.h>
+#include <random_numbers/random_numbers.h>
+#include <ros/serialization.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <limits>
+#include <queue>
+
+namespace moveit {
+namespace task_constructor {
+namespace solvers {
+
+namespace {
+// roadmaps are discarded altogether once this many environments were encountered
+constexpr size_t MAX_ROADMAPS = 16;
+// maximum duration of a single IK call, between which cancellation and deadline are checked
+constexpr double IK_TIME_SLICE = 0.05;
+}  // namespace
+
+/** Roadmap of a single planning group in a single collision environment
+ *
+ * Vertices are collision-free configurations of the group. Edges are validated lazily.
+ */
+struct RoadmapPlanner::Roadmap
+{
+	enum EdgeStatus
+	{
+		UNKNOWN,
+		VALID,
+		INVALID
+	};
+	struct Edge
+	{
+		size_t source;
+		size_t target;
+		double length;
+		EdgeStatus status;
+	};
+	struct Vertex
+	{
+		std::vector<double> positions;
+		std::vector<size_t> edges;  // indices into edges
+	};
+
+	std::vector<Vertex> vertices;
+	std::vector<Edge> edges;
+	random_numbers::RandomNumberGenerator rng;
+	// a roadmap is accessed by a single query at a time
+	std::mutex mutex;
+
+	/// find vertex matching positions or insert a new one, connecting it lazily to its k nearest neighbors
+	size_t addVertex(const moveit::core::JointModelGroup* jmg, std::vector<double> positions, size_t k);
+	/// shortest path from start to goal, ignoring known invalid edges, as list of edge indices
+	std::vector<size_t> shortestPath(const moveit::core::JointModelGroup* jmg, size_t start, size_t goal) const;
+	size_t other(const Edge& e, size_t v) const { return e.source == v ? e.target : e.source; }
+};
+
+size_t RoadmapPlanner::Roadmap::addVertex(const moveit::core::JointModelGroup* jmg, std::vector<double> positions,
+                                          size_t k) {
+	// k nearest neighbors by linear scan, kept sorted by distance
+	std::vector<std::pair<double, size_t>> nearest;
+	for (size_t i = 0; i < vertices.size(); ++i) {
+		double d = jmg->distance(positions.data(), vertices[i].positions.data());
+		if (d < 1e-6)
+			return i;  // reuse existing vertex
+		if (nearest.size() < k || d < nearest.back().first) {
+			auto pos = std::upper_bound(nearest.begin(), nearest.end(), std::make_pair(d, i));
+			nearest.insert(pos, std::make_pair(d, i));
+			if (nearest.size() > k)
+				nearest.pop_back();
+		}
+	}
+
+	size_t index = vertices.size();
+	vertices.push_back(Vertex{ std::move(positions), {} });
+	for (const auto& neighbor : nearest) {
+		vertices[index].edges.push_back(edges.size());
+		vertices[neighbor.second].edges.push_back(edges.size());
+		edges.push_back(Edge{ neighbor.second, index, neighbor.first, UNKNOWN });
+	}
+	return index;
+}
+
+std::vector<size_t> RoadmapPlanner::Roadmap::shortestPath(const moveit::core::JointModelGroup* jmg, size_t start,
+                                                          size_t goal) const {
+	// A* search with straight-line distance heuristic
+	const double inf = std::numeric_limits<double>::infinity();
+	std::vector<double> cost(vertices.size(), inf);
+	std::vector<size_t> via(vertices.size(), edges.size());  // edge leading to vertex
+	using Entry = std::pair<double, size_t>;
+	std::priority_queue<Entry, std::vector<Entry>, std::greater<Entry>> queue;
+	auto heuristic = [&](size_t v) {
+		return jmg->distance(vertices[v].positions.data(), vertices[goal].positions.data());
+	};
+
+	cost[start] = 0.0;
+	queue.emplace(heuristic(start), start);
+	while (!queue.empty()) {
+		const size_t v = queue.top().second;
+		const double estimate = queue.top().first;
+		queue.pop();
+		if (v == goal)
+			break;
+		if (estimate > cost[v] + heuristic(v) + 1e-9)
+			continue;  // outdated entry
+		for (size_t e : vertices[v].edges) {
+			const Edge& edge = edges[e];
+			if (edge.status == INVALID)
+				continue;
+			const size_t w = other(edge, v);
+			const double c = cost[v] + edge.length;
+			if (c < cost[w]) {
+				cost[w] = c;
+				via[w] = e;
+				queue.emplace(c + heuristic(w), w);
+			}
+		}
+	}
+
+	std::vector<size_t> path;
+	if (cost[goal] == inf)
+		return path;
+	for (size_t v = goal; v != start; v = other(edges[via[v]], v))
+		path.push_back(via[v]);
+	std::reverse(path.begin(), path.end());
+	return path;
+}
+
+RoadmapPlanner::RoadmapPlanner() {
+	auto& p = properties();
+	p.declare<double>("max_step", 0.1, "max joint step for edge validation");
+	p.declare<uint>("num_neighbors", 10u, "number of nearest neighbors to connect new vertices to");
+	p.declare<uint>("num_samples", 50u, "number of samples added when start and goal are disconnected");
+	p.declare<uint>("max_vertices", 10000u, "maximum size of a single roadmap");
+}
+
+RoadmapPlanner::~RoadmapPlanner() = default;
+
+void RoadmapPlanner::init(const core::RobotModelConstPtr& /*robot_model*/) {}
+
+void RoadmapPlanner::clear() {
+	std::lock_guard<std::mutex> lock(mutex_);
+	roadmaps_.clear();
+}
+
+size_t RoadmapPlanner::numRoadmaps() const {
+	std::lock_guard<std::mutex> lock(mutex_);
+	return roadmaps_.size();
+}
+
+size_t RoadmapPlanner::numVertices() const {
+	std::lock_guard<std::mutex> lock(mutex_);
+	size_t result = 0;
+	for (const auto& pair : roadmaps_) {
+		std::lock_guard<std::mutex> roadmap_lock(pair.second->mutex);
+		result += pair.second->vertices.size();
+	}
+	return result;
+}
+
+std::shared_ptr<RoadmapPlanner::Roadmap> RoadmapPlanner::roadmap(const std::string& key) {
+	std::lock_guard<std::mutex> lock(mutex_);
+	auto it = roadmaps_.find(key);
+	if (it != roadmaps_.end())
+		return it->second;
+	if (roadmaps_.size() >= MAX_ROADMAPS)
+		roadmaps_.clear();  // roadmaps in use are kept alive by their queries
+	return roadmaps_[key] = std::make_shared<Roadmap>();
+}
+
+bool RoadmapPlanner::plan(const planning_scene::PlanningSceneConstPtr& from,
+                          const planning_scene::PlanningSceneConstPtr& to, const moveit::core::JointModelGroup* jmg,
+                          double timeout, robot_trajectory::RobotTrajectoryPtr& result,
+                          const moveit_msgs::Constraints& path_constraints) {
+	trace::Scope scope("planner", "RoadmapPlanner");
+	if (cancellation::requested())
+		return false;
+	const auto& props = properties();
+	const double max_step = props.get<double>("max_step");
+	const auto deadline = std::chrono::steady_clock::now() + std::chrono::duration<double>(timeout);
+	auto expired = [&deadline]() { return cancellation::requested() || std::chrono::steady_clock::now() > deadline; };
+
+	moveit::core::RobotState state(from->getCurrentState());
+	std::vector<double> start, goal;
+	state.copyJointGroupPositions(jmg, start);
+	to->getCurrentState().copyJointGroupPositions(jmg, goal);
+
+	auto is_valid = [&](const double* positions) {
+		state.setJointGroupPositions(jmg, positions);
+		state.update();
+		return from->isStateValid(state, path_constraints, jmg->getName());
+	};
+	// check interior of the straight-line motion between two configurations
+	std::vector<double> waypoint(start.size());
+	auto is_motion_valid = [&](const std::vector<double>& a, const std::vector<double>& b, double length) {
+		const size_t steps = std::ceil(length / max_step);
+		for (size_t i = 1; i < steps; ++i) {
+			jmg->interpolate(a.data(), b.data(), static_cast<double>(i) / steps, waypoint.data());
+			if (!is_valid(waypoint.data()))
+				return false;
+		}
+		return true;
+	};
+
+	result = std::make_shared<robot_trajectory::RobotTrajectory>(from->getRobotModel(), jmg);
+	result->addSuffixWayPoint(from->getCurrentState(), 0.0);
+	if (!is_valid(start.data()) || !is_valid(goal.data()))
+		return false;
+
+	// roadmaps are specific to the group, the collision environment (including the fixed remaining joints),
+	// and the path constraints
+	std::string key = jmg->getName();
+	key.push_back('\0');
+	key += environmentFingerprint(*from);
+	std::vector<double> fixed(from->getCurrentState().getVariablePositions(),
+	                          from->getCurrentState().getVariablePositions() + state.getVariableCount());
+	for (int index : jmg->getVariableIndexList())
+		fixed[index] = 0.0;
+	key.append(reinterpret_cast<const char*>(fixed.data()), fixed.size() * sizeof(double));
+	const uint32_t size = ros::serialization::serializationLength(path_constraints);
+	std::string buffer(size, '\0');
+	ros::serialization::OStream stream(reinterpret_cast<uint8_t*>(&buffer[0]), size);
+	ros::serialization::serialize(stream, path_constraints);
+	key += buffer;
+
+	std::shared_ptr<Roadmap> roadmap_ptr = roadmap(key);
+	Roadmap& roadmap = *roadmap_ptr;
+	std::lock_guard<std::mutex> lock(roadmap.mutex);
+
+	const size_t k = props.get<uint>("num_neighbors");
+	const size_t s = roadmap.addVertex(jmg, start, k);
+	const size_t g = roadmap.addVertex(jmg, goal, k);
+
+	std::vector<size_t> path;
+	std::vector<double> sample;
+	// search and repair the roadmap, checking the deadline in each round: edge validation and sampling are costly
+	for (bool first = true;; first = false) {
+		if (!first && expired())
+			return false;
+		path = roadmap.shortestPath(jmg, s, g);
+		if (path.empty() && s != g) {  // disconnected: grow roadmap
+			if (roadmap.vertices.size() >= props.get<uint>("max_vertices"))
+				return false;
+			for (uint i = 0, n = props.get<uint>("num_samples"); i < n && !expired(); ++i) {
+				jmg->getVariableRandomPositions(roadmap.rng, sample);
+				if (is_valid(sample.data()))
+					roadmap.addVertex(jmg, sample, k);
+			}
+			continue;
+		}
+
+		// lazily validate edges along path, repairing the path if an edge turns out invalid
+		bool valid = true;
+		for (size_t e : path) {
+			Roadmap::Edge& edge = roadmap.edges[e];
+			if (edge.status == Roadmap::UNKNOWN)
+				edge.status = is_motion_valid(roadmap.vertices[edge.source].positions,
+				                              roadmap.vertices[edge.target].positions, edge.length) ?
+				                  Roadmap::VALID :
+				                  Roadmap::INVALID;
+			if (edge.status == Roadmap::INVALID) {
+				valid = false;
+				break;
+			}
+		}
+		if (valid)
+			break;
+	}
+
+	// densely interpolate the path, finally reaching the exact goal state
+	size_t v = s;
+	for (size_t e : path) {
+		const bool last = e == path.back();
+		const Roadmap::Edge& edge = roadmap.edges[e];
+		const size_t w = roadmap.other(edge, v);
+		const std::vector<double>& a = roadmap.vertices[v].positions;
+		const std::vector<double>& b = roadmap.vertices[w].positions;
+		const size_t steps = std::max<size_t>(1, std::ceil(edge.length / max_step));
+		for (size_t i = 1; i < steps + (last ? 0 : 1); ++i) {
+			jmg->interpolate(a.data(), b.data(), static_cast<double>(i) / steps, waypoint.data());
+			state.setJointGroupPositions(jmg, waypoint);
+			result->addSuffixWayPoint(state, 0.0);
+		}
+		v = w;
+	}
+	result->addSuffixWayPoint(to->getCurrentState(), 0.0);
+
+	// add timing, unless deferred until the solution is used (see deferredTiming())
+	if (!props.get<bool>("lazy_timing"))
+		computeTimeStamps(*result);
+	return true;
+}
+
+bool RoadmapPlanner::plan(const planning_scene::PlanningSceneConstPtr& from, const moveit::core::LinkModel& link,
+                          const Eigen::Isometry3d& target, const moveit::core::JointModelGroup* jmg, double timeout,
+                          robot_trajectory::RobotTrajectoryPtr& result,
+                          const moveit_msgs::Constraints& path_constraints) {
+	const auto start_time = std::chrono::steady_clock::now();
+	planning_scene::PlanningScenePtr to = from->diff();
+	moveit::core::RobotState& goal = to->getCurrentStateNonConst();
+	moveit::core::GroupStateValidityCallbackFn is_valid = [&from, &path_constraints](
+	    moveit::core::RobotState* state, const moveit::core::JointModelGroup* jmg, const double* positions) {
+		state->setJointGroupPositions(jmg, positions);
+		state->update();
+		return from->isStateValid(*state, path_constraints, jmg->getName());
+	};
+	// a rejecting validity callback lets IK retry until its timeout: leave half of the budget for the search
+	// and solve in short slices to react to cancellation
+	const double ik_timeout = timeout / 2.0;
+	double remaining = ik_timeout;
+	bool succeeded = false;
+	do {
+		succeeded = goal.setFromIK(jmg, target, link.getName(), std::min(remaining, IK_TIME_SLICE), is_valid);
+		remaining = ik_timeout - std::chrono::duration<double>(std::chrono::steady_clock::now() - start_time).count();
+	} while (!succeeded && remaining > 0.0 && !cancellation::requested());
+	if (!succeeded)
+		return false;
+	goal.update();
+
+	timeout -= std::chrono::duration<double>(std::chrono::steady_clock::now() - start_time).count();
+	return plan(from, to, jmg, timeout, result, path_constraints);
+}
+}  // namespace solvers
+}  // namespace task_constructor
+}  // namespace moveit
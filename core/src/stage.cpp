@@ -39,6 +39,7 @@
 #include <moveit/task_constructor/container_p.h>
 #include <moveit/task_constructor/introspection.h>
 #include <moveit/planning_scene/planning_scene.h>
+#include <moveit/robot_trajectory/robot_trajectory.h>
 
 #include <ros/console.h>
 
@@ -48,6 +49,9 @@
 #include <iomanip>
 #include <algorithm>
 #include <utility>
+#include <limits>
+#include <set>
+#include <cmath>
 
 namespace moveit {
 namespace task_constructor {
@@ -96,9 +100,97 @@ std::ostream& operator<<(std::ostream& os, const InitStageException& e) {
 	return os;
 }
 
+static const double HISTOGRAM_BASE = 1e-6;  // upper bound of first bucket: 1us
+
+void ComputeTimeHistogram::add(double seconds) {
+	size_t bucket = 0;
+	if (seconds > HISTOGRAM_BASE)
+		bucket = std::min<size_t>(NUM_BUCKETS - 1, std::ceil(2.0 * std::log2(seconds / HISTOGRAM_BASE)));
+	++buckets_[bucket];
+	++count_;
+	max_ = std::max(max_, seconds);
+}
+
+double ComputeTimeHistogram::percentile(double fraction) const {
+	if (count_ == 0)
+		return 0.0;
+	const size_t target = std::max<size_t>(1, std::ceil(fraction * count_));
+	size_t accumulated = 0;
+	for (size_t bucket = 0; bucket < NUM_BUCKETS; ++bucket) {
+		accumulated += buckets_[bucket];
+		if (accumulated >= target)  // report upper bound of bucket, but never more than the actual maximum
+			return std::min(max_, HISTOGRAM_BASE * std::pow(2.0, 0.5 * bucket));
+	}
+	return max_;
+}
+
 StagePrivate::StagePrivate(Stage* me, const std::string& name)
   : me_(me), name_(name), total_compute_time_{}, parent_(nullptr), introspection_(nullptr) {}
 
+double StagePrivate::remainingTime() const {
+	if (deadline_ == std::chrono::steady_clock::time_point::max())
+		return std::numeric_limits<double>::infinity();
+	std::chrono::duration<double> remaining = deadline_ - std::chrono::steady_clock::now();
+	return std::max(0.0, remaining.count());
+}
+
+InterfaceState::Priority StagePrivate::pendingPriority() const {
+	// stages without pending states (e.g. generators) come last
+	InterfaceState::Priority result(0, std::numeric_limits<double>::infinity());
+	if (starts_ && !starts_->empty())
+		result = std::min(result, starts_->front()->priority());
+	if (ends_ && !ends_->empty())
+		result = std::min(result, ends_->front()->priority());
+	return result;
+}
+
+template <Interface::Direction dir>
+static void pruneInterface(Interface& interface, double bound) {
+	// release solutions only leading to pruned states, i.e. states that were not yet continued
+	for (InterfaceState* state : interface.prune(bound)) {
+		if (!(dir == Interface::FORWARD ? state->outgoingTrajectories() : state->incomingTrajectories()).empty())
+			continue;
+		for (SolutionBase* solution :
+		     dir == Interface::FORWARD ? state->incomingTrajectories() : state->outgoingTrajectories())
+			solution->release();
+	}
+}
+
+void StagePrivate::pruneStates(double bound) {
+	if (starts_)
+		pruneInterface<Interface::FORWARD>(*starts_, bound);
+	if (ends_)
+		pruneInterface<Interface::BACKWARD>(*ends_, bound);
+}
+
+void StagePrivate::releaseSolutions(double bound, const std::set<const SolutionBase*>& keep) {
+	// solutions are sorted by cost: process from the back
+	for (auto it = solutions_.rbegin(); it != solutions_.rend() && (*it)->cost() > bound; ++it) {
+		if (!keep.count(it->get()))
+			const_cast<SolutionBase&>(**it).release();
+	}
+}
+
+void StagePrivate::dropSolutions(size_t keep) {
+	while (solutions_.size() > keep) {
+		dropped_.push_back(solutions_.back());
+		solutions_.erase(std::prev(solutions_.end()));
+	}
+
+	// finally discard solutions not referenced anymore outside of dropped_
+	for (auto it = dropped_.begin(); it != dropped_.end();) {
+		if (it->use_count() > 1) {
+			++it;
+			continue;
+		}
+		SolutionBase& solution = const_cast<SolutionBase&>(**it);
+		if (introspection_)
+			introspection_->releaseSolution(solution);
+		solution.detachStates();
+		it = dropped_.erase(it);
+	}
+}
+
 InterfaceFlags StagePrivate::interfaceFlags() const {
 	InterfaceFlags f;
 	if (starts())
@@ -126,27 +218,81 @@ void StagePrivate::validateConnectivity() const {
 
 bool StagePrivate::storeSolution(const SolutionBasePtr& solution) {
 	solution->setCreator(this);
-	if (introspection_)
-		introspection_->registerSolution(*solution);
 
 	if (solution->isFailure()) {
 		++num_failures_;
-		if (!storeFailures())
+		if (!storeFailures() || !retainFailure())
 			return false;  // drop solution
 		failures_.push_back(solution);
 	} else {
 		solutions_.insert(solution);
 	}
+	if (introspection_)
+		introspection_->registerSolution(*solution);
+	return true;
+}
+
+bool StagePrivate::retainFailure() {
+	switch (failure_retention_) {
+		case Stage::KEEP_ALL:
+			return true;
+		case Stage::KEEP_LAST:
+			if (failure_capacity_ == 0)
+				return false;
+			while (failures_.size() >= failure_capacity_)
+				evictFailure(failures_.begin());
+			return true;
+		case Stage::RESERVOIR: {
+			if (failures_.size() < failure_capacity_)
+				return true;
+			if (failure_capacity_ == 0)
+				return false;
+			// keep the n-th failure with probability capacity / n, replacing a random one
+			size_t index = std::uniform_int_distribution<size_t>(0, num_failures_ - 1)(failure_sampler_);
+			if (index >= failures_.size())
+				return false;
+			evictFailure(std::next(failures_.begin(), index));
+			return true;
+		}
+	}
 	return true;
 }
 
+void StagePrivate::evictFailure(std::list<SolutionBaseConstPtr>::iterator it) {
+	SolutionBase& failure = const_cast<SolutionBase&>(**it);
+	if (introspection_)
+		introspection_->releaseSolution(failure);
+
+	// release states created for this failure only
+	failure.detachStates();
+	auto states = failure_states_.find(&failure);
+	if (states != failure_states_.end()) {
+		for (auto state_it : states->second) {
+			if (!state_it->owner() && state_it->incomingTrajectories().empty() &&
+			    state_it->outgoingTrajectories().empty())
+				states_.erase(state_it);
+		}
+		failure_states_.erase(states);
+	}
+	failures_.erase(it);
+}
+
+void StagePrivate::trackFailureStates(const SolutionBase& failure,
+                                      std::initializer_list<std::list<InterfaceState>::iterator> states) {
+	if (failure.isFailure() && failure_retention_ != Stage::KEEP_ALL)
+		failure_states_[&failure].assign(states);
+}
+
 void StagePrivate::sendForward(const InterfaceState& from, InterfaceState&& to, const SolutionBasePtr& solution) {
 	assert(nextStarts());
+	trace::Scope scope("sendForward", name_.c_str());
 	if (!storeSolution(solution))
 		return;  // solution dropped
 	me()->forwardProperties(from, to);
+	to.flattenScene(scene_flattening_);
 
 	auto to_it = states_.insert(states_.end(), std::move(to));
+	trackFailureStates(*solution, { to_it });
 
 	solution->setStartState(from);
 	solution->setEndState(*to_it);
@@ -159,11 +305,14 @@ void StagePrivate::sendForward(const InterfaceState& from, InterfaceState&& to,
 
 void StagePrivate::sendBackward(InterfaceState&& from, const InterfaceState& to, const SolutionBasePtr& solution) {
 	assert(prevEnds());
+	trace::Scope scope("sendBackward", name_.c_str());
 	if (!storeSolution(solution))
 		return;  // solution dropped
 	me()->forwardProperties(to, from);
+	from.flattenScene(scene_flattening_);
 
 	auto from_it = states_.insert(states_.end(), std::move(from));
+	trackFailureStates(*solution, { from_it });
 
 	solution->setStartState(*from_it);
 	solution->setEndState(to);
@@ -176,11 +325,14 @@ void StagePrivate::sendBackward(InterfaceState&& from, const InterfaceState& to,
 
 void StagePrivate::spawn(InterfaceState&& state, const SolutionBasePtr& solution) {
 	assert(prevEnds() && nextStarts());
+	trace::Scope scope("spawn", name_.c_str());
 	if (!storeSolution(solution))
 		return;  // solution dropped
+	state.flattenScene(scene_flattening_);
 
 	auto from = states_.insert(states_.end(), InterfaceState(state));  // copy
 	auto to = states_.insert(states_.end(), std::move(state));
+	trackFailureStates(*solution, { from, to });
 
 	solution->setStartState(*from);
 	solution->setEndState(*to);
@@ -194,6 +346,7 @@ void StagePrivate::spawn(InterfaceState&& state, const SolutionBasePtr& solution
 }
 
 void StagePrivate::connect(const InterfaceState& from, const InterfaceState& to, const SolutionBasePtr& solution) {
+	trace::Scope scope("connect", name_.c_str());
 	if (!storeSolution(solution))
 		return;  // solution dropped
 
@@ -208,8 +361,10 @@ void StagePrivate::newSolution(const SolutionBasePtr& solution) {
 	for (const auto& cb : solution_cbs_)
 		cb(*solution);
 
-	if (parent() && !solution->isFailure())
+	if (parent() && !solution->isFailure()) {
+		trace::Scope scope("onNewSolution", parent()->name().c_str());
 		parent()->onNewSolution(*solution);
+	}
 }
 
 Stage::Stage(StagePrivate* impl) : pimpl_(impl) {
@@ -239,8 +394,11 @@ void Stage::reset() {
 	// clear solutions + associated states
 	impl->solutions_.clear();
 	impl->failures_.clear();
+	impl->dropped_.clear();
 	impl->num_failures_ = 0u;
+	impl->failure_states_.clear();
 	impl->states_.clear();
+	impl->deadline_ = std::chrono::steady_clock::time_point::max();
 	// clear pull interfaces
 	if (impl->starts_)
 		impl->starts_->clear();
@@ -258,6 +416,8 @@ void Stage::init(const moveit::core::RobotModelConstPtr& robot_model) {
 	auto impl = pimpl();
 	impl->properties_.reset();
 	if (impl->parent()) {
+		if (!impl->scene_flattening_configured_)
+			impl->scene_flattening_ = impl->parent()->pimpl()->scene_flattening_;
 		try {
 			ROS_DEBUG_STREAM_NAMED("Properties", "init '" << name() << "'");
 			impl->properties_.performInitFrom(PARENT, impl->parent()->properties());
@@ -283,6 +443,22 @@ void Stage::setName(const std::string& name) {
 	pimpl_->name_ = name;
 }
 
+namespace {
+// smallest timeout passed to solvers once the deadline is reached (seconds)
+constexpr double MIN_TIMEOUT = 1e-6;
+}  // namespace
+
+double Stage::timeout() const {
+	double timeout = properties().get<double>("timeout");
+	double remaining = pimpl()->remainingTime();
+	if (std::isinf(remaining))
+		return timeout;
+	// solvers interpret zero as their default timeout: never pass it to make them fail fast instead
+	remaining = std::max(remaining, MIN_TIMEOUT);
+	// negative timeouts indicate waiting forever
+	return timeout < 0.0 ? remaining : std::min(timeout, remaining);
+}
+
 void Stage::forwardProperties(const InterfaceState& source, InterfaceState& dest) {
 	const PropertyMap& src = source.properties();
 	PropertyMap& dst = dest.properties();
@@ -322,6 +498,18 @@ bool Stage::storeFailures() const {
 	return pimpl()->storeFailures();
 }
 
+void Stage::setFailureRetention(Stage::FailureRetention policy, size_t capacity) {
+	auto impl = pimpl();
+	impl->failure_retention_ = policy;
+	impl->failure_capacity_ = capacity;
+}
+
+void Stage::setSceneFlattening(const InterfaceState::SceneFlattening& policy) {
+	auto impl = pimpl();
+	impl->scene_flattening_ = policy;
+	impl->scene_flattening_configured_ = true;
+}
+
 PropertyMap& Stage::properties() {
 	return pimpl()->properties_;
 }
@@ -334,6 +522,87 @@ double Stage::getTotalComputeTime() const {
 	return pimpl()->total_compute_time_.count();
 }
 
+size_t Stage::numComputeCalls() const {
+	return pimpl()->num_computes_;
+}
+
+double Stage::computeTimePercentile(double fraction) const {
+	return pimpl()->compute_time_histogram_.percentile(fraction);
+}
+
+double Stage::maxComputeTime() const {
+	return pimpl()->compute_time_histogram_.max();
+}
+
+size_t Stage::maxPendingStates(Interface::Direction dir) const {
+	return dir == Interface::FORWARD ? pimpl()->max_pending_starts_ : pimpl()->max_pending_ends_;
+}
+
+MemoryUsage& MemoryUsage::operator+=(const MemoryUsage& other) {
+	states += other.states;
+	scenes += other.scenes;
+	trajectories += other.trajectories;
+	markers += other.markers;
+	return *this;
+}
+
+namespace {
+size_t estimateBytes(const moveit::core::RobotState& state) {
+	// variable positions, velocities, accelerations + joint, link, and collision body transforms
+	const moveit::core::RobotModel& model = *state.getRobotModel();
+	return sizeof(moveit::core::RobotState) + 3 * model.getVariableCount() * sizeof(double) +
+	       (model.getJointModelCount() + 2 * model.getLinkModelCount()) * sizeof(Eigen::Isometry3d);
+}
+
+size_t estimateBytes(const planning_scene::PlanningScene& scene) {
+	size_t bytes = sizeof(planning_scene::PlanningScene) + estimateBytes(scene.getCurrentState());
+	// diff scenes hold a copy of the world, sharing the shapes
+	for (const auto& pair : *scene.getWorld())
+		bytes += sizeof(collision_detection::World::Object) + pair.first.size() +
+		         pair.second->shape_poses_.size() * (sizeof(Eigen::Isometry3d) + sizeof(shapes::ShapeConstPtr));
+	return bytes;
+}
+
+size_t estimateBytes(const visualization_msgs::Marker& m) {
+	return sizeof(m) + m.points.size() * sizeof(geometry_msgs::Point) + m.colors.size() * sizeof(std_msgs::ColorRGBA) +
+	       m.ns.size() + m.text.size() + m.mesh_resource.size();
+}
+
+void accountSolution(const SolutionBase& s, MemoryUsage& usage) {
+	for (const auto& marker : s.markers())
+		usage.markers += estimateBytes(marker);
+
+	// only SubTrajectories own a trajectory, other solutions refer to their children's solutions
+	const SubTrajectory* sub = dynamic_cast<const SubTrajectory*>(&s);
+	if (!sub || !sub->trajectory() || sub->trajectory()->empty())
+		return;
+	const robot_trajectory::RobotTrajectory& t = *sub->trajectory();
+	usage.trajectories += t.getWayPointCount() * (estimateBytes(t.getWayPoint(0)) + sizeof(double));
+}
+}  // namespace
+
+MemoryUsage Stage::memoryUsage() const {
+	auto impl = pimpl();
+	MemoryUsage usage;
+
+	// containers only copy their children's states, sharing their scenes
+	const bool own_scenes = !dynamic_cast<const ContainerBase*>(this);
+	std::set<const planning_scene::PlanningScene*> scenes;  // count shared scenes only once
+	for (const InterfaceState& state : impl->states_) {
+		const size_t num_trajectories = state.incomingTrajectories().size() + state.outgoingTrajectories().size();
+		usage.states += sizeof(InterfaceState) + num_trajectories * sizeof(SolutionBase*);
+		// don't force creation of lazy scenes
+		if (own_scenes && state.sceneMaterialized() && scenes.insert(state.scene().get()).second)
+			usage.scenes += estimateBytes(*state.scene());
+	}
+
+	for (const auto& solution : impl->solutions_)
+		accountSolution(*solution, usage);
+	for (const auto& solution : impl->failures_)
+		accountSolution(*solution, usage);
+	return usage;
+}
+
 void StagePrivate::composePropertyErrorMsg(const std::string& property_name, std::ostream& os) {
 	if (property_name.empty())
 		return;
@@ -392,6 +661,11 @@ std::ostream& operator<<(std::ostream& os, const StagePrivate& impl) {
 
 ComputeBase::ComputeBase(ComputeBasePrivate* impl) : Stage(impl) {}
 
+namespace {
+// maximum number of inputs with cached results per stage
+constexpr size_t RESULT_CACHE_CAPACITY = 4096;
+}  // namespace
+
 PropagatingEitherWayPrivate::PropagatingEitherWayPrivate(PropagatingEitherWay* me, PropagatingEitherWay::Direction dir,
                                                          const std::string& name)
   : ComputeBasePrivate(me, name), configured_dir_(dir) {
@@ -485,16 +759,80 @@ void PropagatingEitherWayPrivate::compute() {
 		const InterfaceState& state = fetchStartState();
 		// enforce property initialization from INTERFACE
 		properties_.performInitFrom(Stage::INTERFACE, state.properties());
-		me->computeForward(state);
+		computeCached(state, PropagatingEitherWay::FORWARD);
 	}
 	if (hasEndState()) {
 		const InterfaceState& state = fetchEndState();
 		// enforce property initialization from INTERFACE
 		properties_.performInitFrom(Stage::INTERFACE, state.properties());
-		me->computeBackward(state);
+		computeCached(state, PropagatingEitherWay::BACKWARD);
 	}
 }
 
+bool PropagatingEitherWayPrivate::cacheKey(const InterfaceState& state, PropagatingEitherWay::Direction dir,
+                                           std::string& key) const {
+	key.assign(1, static_cast<char>(dir));
+	key.append(sceneFingerprint(*state.scene()));
+	for (const PropertyMap* properties : { &state.properties(), &properties_ }) {
+		key.push_back('\0');
+		for (const auto& pair : *properties) {
+			if (!pair.second.serializable())
+				return false;  // different values would share the same key
+			key.append(pair.first).append(":").append(pair.second.serialize()).push_back('\0');
+		}
+	}
+	return true;
+}
+
+void PropagatingEitherWayPrivate::clearResultCache() {
+	result_cache_.clear();
+	result_cache_lru_.clear();
+}
+
+void PropagatingEitherWayPrivate::computeCached(const InterfaceState& state, PropagatingEitherWay::Direction dir) {
+	auto me = static_cast<PropagatingEitherWay*>(me_);
+	auto compute = [me, dir, &state]() {
+		if (dir == PropagatingEitherWay::FORWARD)
+			me->computeForward(state);
+		else
+			me->computeBackward(state);
+	};
+	std::string key;
+	if (!result_caching_ || !cacheKey(state, dir, key))
+		return compute();
+
+	auto it = result_cache_.find(key);
+	if (it != result_cache_.end()) {
+		++num_cache_hits_;
+		result_cache_lru_.splice(result_cache_lru_.end(), result_cache_lru_, it->second.lru);
+		for (const CachedResult& result : it->second.results) {
+			if (dir == PropagatingEitherWay::FORWARD)
+				sendForward(state, InterfaceState(result.state), std::make_shared<SubTrajectory>(result.trajectory));
+			else
+				sendBackward(InterfaceState(result.state), state, std::make_shared<SubTrajectory>(result.trajectory));
+		}
+		return;
+	}
+
+	// bound memory: evict least recently used entry
+	if (result_cache_.size() >= RESULT_CACHE_CAPACITY) {
+		result_cache_.erase(*result_cache_lru_.front());
+		result_cache_lru_.pop_front();
+	}
+	it = result_cache_.emplace(key, CacheEntry()).first;
+	it->second.lru = result_cache_lru_.insert(result_cache_lru_.end(), &it->first);
+	recording_ = &it->second.results;
+	try {
+		compute();
+	} catch (...) {  // don't cache incomplete results
+		recording_ = nullptr;
+		result_cache_lru_.erase(it->second.lru);
+		result_cache_.erase(it);
+		throw;
+	}
+	recording_ = nullptr;
+}
+
 PropagatingEitherWay::PropagatingEitherWay(const std::string& name)
   : PropagatingEitherWay(new PropagatingEitherWayPrivate(this, AUTO, name)) {}
 
@@ -510,12 +848,38 @@ void PropagatingEitherWay::restrictDirection(PropagatingEitherWay::Direction dir
 	impl->initInterface(dir);
 }
 
+void PropagatingEitherWay::setResultCaching(bool enable) {
+	pimpl()->result_caching_ = enable;
+	if (!enable)
+		clearResultCache();
+}
+
+bool PropagatingEitherWay::resultCaching() const {
+	return pimpl()->result_caching_;
+}
+
+void PropagatingEitherWay::clearResultCache() {
+	auto impl = pimpl();
+	impl->clearResultCache();
+	impl->num_cache_hits_ = 0;
+}
+
+size_t PropagatingEitherWay::numCacheHits() const {
+	return pimpl()->num_cache_hits_;
+}
+
 void PropagatingEitherWay::sendForward(const InterfaceState& from, InterfaceState&& to, SubTrajectory&& t) {
-	pimpl()->sendForward(from, std::move(to), std::make_shared<SubTrajectory>(std::move(t)));
+	auto impl = pimpl();
+	if (impl->recording_)
+		impl->recording_->push_back({ InterfaceState(to), t });
+	impl->sendForward(from, std::move(to), std::make_shared<SubTrajectory>(std::move(t)));
 }
 
 void PropagatingEitherWay::sendBackward(InterfaceState&& from, const InterfaceState& to, SubTrajectory&& t) {
-	pimpl()->sendBackward(std::move(from), to, std::make_shared<SubTrajectory>(std::move(t)));
+	auto impl = pimpl();
+	if (impl->recording_)
+		impl->recording_->push_back({ InterfaceState(from), t });
+	impl->sendBackward(std::move(from), to, std::make_shared<SubTrajectory>(std::move(t)));
 }
 
 PropagatingForwardPrivate::PropagatingForwardPrivate(PropagatingForward* me, const std::string& name)
@@ -654,17 +1018,89 @@ bool ConnectingPrivate::canCompute() const {
 	return !pending.empty();
 }
 
+InterfaceState::Priority ConnectingPrivate::pendingPriority() const {
+	if (pending.empty())
+		return InterfaceState::Priority(0, std::numeric_limits<double>::infinity());
+	const StatePair& top = pending.top();
+	return top.first->priority() + top.second->priority();
+}
+
+void ConnectingPrivate::pruneStates(double bound) {
+	// remove pending pairs first, as they refer to interface states
+	pending.remove_if([this, bound](const StatePair& p) {
+		if (p.first->priority().cost() + p.second->priority().cost() <= bound)
+			return false;
+		ungrouped_.erase(std::make_pair(&*p.first, &*p.second));
+		return true;
+	});
+	ComputeBasePrivate::pruneStates(bound);
+}
+
 void ConnectingPrivate::compute() {
-	const StatePair& top = pending.pop();
+	const StatePair top = pending.pop();
 	const InterfaceState& from = *top.first;
 	const InterfaceState& to = *top.second;
-	static_cast<Connecting*>(me_)->compute(from, to);
+	if (max_group_size_ <= 1 || ungrouped_.erase(std::make_pair(&from, &to))) {
+		static_cast<Connecting*>(me_)->compute(from, to);
+		return;
+	}
+
+	// group with other pending pairs sharing the start or the end state, whichever has more partners
+	auto num_starts = std::count_if(pending.begin(), pending.end(),
+	                                [&top](const StatePair& p) { return p.first == top.first; });
+	auto num_ends = std::count_if(pending.begin(), pending.end(),
+	                              [&top](const StatePair& p) { return p.second == top.second; });
+	const bool by_start = num_starts >= num_ends;
+	std::vector<StatePair> grouped{ top };
+	pending.remove_if([this, &top, &grouped, by_start](const StatePair& p) {
+		if (grouped.size() >= max_group_size_ || (by_start ? p.first != top.first : p.second != top.second) ||
+		    ungrouped_.count(std::make_pair(&*p.first, &*p.second)))
+			return false;
+		grouped.push_back(p);
+		return true;
+	});
+
+	if (grouped.size() == 1)
+		return static_cast<Connecting*>(me_)->compute(from, to);
+
+	Connecting::StatePairList group;
+	for (const StatePair& p : grouped)
+		group.emplace_back(&*p.first, &*p.second);
+	// queue unhandled pairs again
+	const Connecting::StatePairList unhandled = static_cast<Connecting*>(me_)->computeGroup(group);
+	// if the group failed as a whole, none of its pairs was tried on its own yet: don't group them again
+	const bool failed = unhandled.size() == grouped.size();
+	for (const auto& p : unhandled) {
+		auto it = std::find_if(grouped.begin(), grouped.end(), [&p](const StatePair& g) {
+			return &*g.first == p.first && &*g.second == p.second;
+		});
+		if (it == grouped.end())
+			continue;
+		pending.insert(*it);
+		if (failed)
+			ungrouped_.insert(p);
+	}
 }
 
 Connecting::Connecting(const std::string& name) : ComputeBase(new ConnectingPrivate(this, name)) {}
 
+void Connecting::setMaxGroupSize(size_t n) {
+	pimpl()->max_group_size_ = n;
+}
+
+size_t Connecting::maxGroupSize() const {
+	return pimpl()->max_group_size_;
+}
+
+Connecting::StatePairList Connecting::computeGroup(const StatePairList& pairs) {
+	for (const auto& pair : pairs)
+		compute(*pair.first, *pair.second);
+	return {};
+}
+
 void Connecting::reset() {
 	pimpl()->pending.clear();
+	pimpl()->ungrouped_.clear();
 	ComputeBase::reset();
 }
 
@@ -36,6 +36,7 @@
 
 #include <moveit/task_constructor/stages/compute_ik.h>
 #include <moveit/task_constructor/storage.h>
+#include <moveit/task_constructor/cancellation.h>
 #include <moveit/task_constructor/marker_tools.h>
 
 #include <moveit/planning_scene/planning_scene.h>
@@ -44,6 +45,7 @@
 
 #include <Eigen/Geometry>
 #include <eigen_conversions/eigen_msg.h>
+#include <algorithm>
 #include <chrono>
 #include <functional>
 #include <iterator>
@@ -62,6 +64,8 @@ ComputeIK::ComputeIK(const std::string& name, Stage::pointer&& child) : WrapperB
 	p.declare<bool>("ignore_collisions", false);
 	p.declare<double>("min_solution_distance", 0.1,
 	                  "minimum distance between seperate IK solutions for the same target");
+	p.declare<ReachabilityMapConstPtr>("reachability_map", ReachabilityMapConstPtr(),
+	                                   "precomputed map to prioritize likely reachable targets");
 
 	// ik_frame and target_pose are read from the interface
 	p.declare<geometry_msgs::PoseStamped>("ik_frame", "frame to be moved towards goal pose");
@@ -86,6 +90,8 @@ void ComputeIK::setTargetPose(const Eigen::Isometry3d& pose, const std::string&
 typedef std::vector<std::vector<double>> IKSolutions;
 
 namespace {
+// maximum duration of a single IK call, between which cancellation is checked
+constexpr double IK_TIME_SLICE = 0.05;
 
 // ??? TODO: provide callback methods in PlanningScene class / probably not very useful here though...
 // TODO: move into MoveIt! core, lift active_components_only_ from fcl to common interface
@@ -177,6 +183,7 @@ bool validateGroup(const PropertyMap& props, const moveit::core::RobotModelConst
 
 void ComputeIK::reset() {
 	upstream_solutions_.clear();
+	deferred_solutions_.clear();
 	WrapperBase::reset();
 }
 
@@ -213,17 +220,21 @@ void ComputeIK::onNewSolution(const SolutionBase& s) {
 }
 
 bool ComputeIK::canCompute() const {
-	return !upstream_solutions_.empty() || WrapperBase::canCompute();
+	return !upstream_solutions_.empty() || !deferred_solutions_.empty() || WrapperBase::canCompute();
 }
 
 void ComputeIK::compute() {
 	if (WrapperBase::canCompute())
 		WrapperBase::compute();
 
-	if (upstream_solutions_.empty())
+	// deferred targets are only processed when no other ones are left
+	const bool deferred = upstream_solutions_.empty();
+	if (deferred && deferred_solutions_.empty())
 		return;
 
-	const SolutionBase& s = *upstream_solutions_.pop();
+	const SolutionBase& s = deferred ? *deferred_solutions_.front() : *upstream_solutions_.pop();
+	if (deferred)
+		deferred_solutions_.pop_front();
 
 	// -1 TODO: this should not be necessary in my opinion: Why do you think so?
 	// It is, because the properties on the interface might change from call to call...
@@ -309,6 +320,17 @@ void ComputeIK::compute() {
 		target_pose = target_pose * ik_pose.inverse();
 	}
 
+	// postpone targets outside the (sampled) reachable workspace while other targets are pending
+	const auto& reachability = props.get<ReachabilityMapConstPtr>("reachability_map");
+	if (!deferred && reachability && reachability->robotName() == robot_model->getName() &&
+	    reachability->group() == jmg->getName() && reachability->tip() == link->getName()) {
+		const Eigen::Isometry3d& base = sandbox_scene->getCurrentState().getGlobalLinkTransform(reachability->baseLink());
+		if (!reachability->reachable(base.inverse() * target_pose)) {
+			deferred_solutions_.push_back(&s);
+			return;
+		}
+	}
+
 	// validate placed link for collisions
 	collision_detection::CollisionResult collisions;
 	bool colliding = !ignore_collisions && isTargetPoseColliding(sandbox_scene, target_pose, link, &collisions);
@@ -356,6 +378,8 @@ void ComputeIK::compute() {
 	IKSolutions ik_solutions;
 	auto is_valid = [sandbox_scene, ignore_collisions, min_solution_distance, &ik_solutions](
 	    robot_state::RobotState* state, const robot_model::JointModelGroup* jmg, const double* joint_positions) {
+		if (cancellation::requested())
+			return false;  // reject further solutions
 		for (const auto& sol : ik_solutions) {
 			if (jmg->distance(joint_positions, sol.data()) < min_solution_distance)
 				return false;  // too close to already found solution
@@ -372,22 +396,26 @@ void ComputeIK::compute() {
 
 	double remaining_time = timeout();
 	auto start_time = std::chrono::steady_clock::now();
-	while (ik_solutions.size() < max_ik_solutions && remaining_time > 0) {
+	while (ik_solutions.size() < max_ik_solutions && remaining_time > 0 && !cancellation::requested()) {
 		if (tried_current_state_as_seed)
 			sandbox_state.setToRandomPositions(jmg);
 		tried_current_state_as_seed = true;
 
 		size_t previous = ik_solutions.size();
-		bool succeeded = sandbox_state.setFromIK(jmg, target_pose, link->getName(), remaining_time, is_valid);
-
-		auto now = std::chrono::steady_clock::now();
-		remaining_time -= std::chrono::duration<double>(now - start_time).count();
-		start_time = now;
+		bool succeeded = false;
+		// IK keeps sampling until its timeout once the validity callback rejects (also on cancellation),
+		// hence solve in short slices to react to cancellation quickly
+		do {
+			succeeded = sandbox_state.setFromIK(jmg, target_pose, link->getName(),
+			                                    std::min(remaining_time, IK_TIME_SLICE), is_valid);
+
+			auto now = std::chrono::steady_clock::now();
+			remaining_time -= std::chrono::duration<double>(now - start_time).count();
+			start_time = now;
+		} while (!succeeded && remaining_time > 0 && !cancellation::requested());
 
 		// for all new solutions (successes and failures)
 		for (size_t i = previous; i != ik_solutions.size(); ++i) {
-			// create a new scene for each solution as they will have different robot states
-			planning_scene::PlanningScenePtr scene = s.start()->scene()->diff();
 			SubTrajectory solution;
 			solution.setComment(s.comment());
 
@@ -401,12 +429,8 @@ void ComputeIK::compute() {
 			else  // found an IK solution, but this was not valid
 				solution.markAsFailure();
 
-			// set scene's robot state
-			robot_state::RobotState& robot_state = scene->getCurrentStateNonConst();
-			robot_state.setJointGroupPositions(jmg, ik_solutions.back().data());
-			robot_state.update();
-
-			InterfaceState state(scene);
+			// a new scene for each solution, with the solution's robot state, is only created when needed
+			InterfaceState state(s.start()->scene(), jmg, ik_solutions.back());
 			forwardProperties(*s.start(), state);
 			spawn(std::move(state), std::move(solution));
 		}
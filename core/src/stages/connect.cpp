@@ -37,9 +37,16 @@
 */
 
 #include <moveit/task_constructor/stages/connect.h>
+#include <moveit/task_constructor/cancellation.h>
 #include <moveit/task_constructor/merge.h>
+#include <moveit/task_constructor/timing.h>
 #include <moveit/planning_scene/planning_scene.h>
 
+#include <algorithm>
+#include <chrono>
+#include <future>
+#include <map>
+
 namespace moveit {
 namespace task_constructor {
 namespace stages {
@@ -132,6 +139,11 @@ void Connect::compute(const InterfaceState& from, const InterfaceState& to) {
 	MergeMode mode = props.get<MergeMode>("merge_mode");
 	const auto& path_constraints = props.get<moveit_msgs::Constraints>("path_constraints");
 
+	// plan of the first group is reused if parallel planning failed
+	robot_trajectory::RobotTrajectoryPtr first_trajectory;
+	if (mode == PARALLEL && merged_jmg_ && computeParallel(from, to, first_trajectory))
+		return;
+
 	const moveit::core::RobotState& final_goal_state = to.scene()->getCurrentState();
 	std::vector<robot_trajectory::RobotTrajectoryConstPtr> sub_trajectories;
 
@@ -152,7 +164,11 @@ void Connect::compute(const InterfaceState& from, const InterfaceState& to) {
 		intermediate_scenes.push_back(end);
 
 		robot_trajectory::RobotTrajectoryPtr trajectory;
-		success = pair.second->plan(start, end, jmg, timeout, trajectory, path_constraints);
+		if (first_trajectory) {  // first group was planned from the same start already
+			trajectory = std::move(first_trajectory);
+			success = true;
+		} else
+			success = pair.second->plan(start, end, jmg, timeout, trajectory, path_constraints);
 		sub_trajectories.push_back(trajectory);  // include failed trajectory
 
 		if (!success)
@@ -172,6 +188,123 @@ void Connect::compute(const InterfaceState& from, const InterfaceState& to) {
 	connect(from, to, solution);
 }
 
+bool Connect::computeParallel(const InterfaceState& from, const InterfaceState& to,
+                              robot_trajectory::RobotTrajectoryPtr& first) {
+	const auto& props = properties();
+	const double timeout = this->timeout();
+	const auto& path_constraints = props.get<moveit_msgs::Constraints>("path_constraints");
+	const planning_scene::PlanningSceneConstPtr& start = from.scene();
+	const moveit::core::RobotState& final_goal_state = to.scene()->getCurrentState();
+
+	// each group is planned from the start scene to its own goal, not moving other groups
+	std::vector<planning_scene::PlanningSceneConstPtr> goals;
+	std::vector<const moveit::core::JointModelGroup*> jmgs;
+	// planners are not assumed to be thread-safe: planners sharing a key (e.g. a pipeline) are called in one thread
+	std::map<const void*, std::vector<size_t>> jobs;
+	std::vector<double> positions;
+	for (size_t i = 0; i < planner_.size(); ++i) {
+		const moveit::core::JointModelGroup* jmg = final_goal_state.getJointModelGroup(planner_[i].first);
+		planning_scene::PlanningScenePtr goal = start->diff();
+		final_goal_state.copyJointGroupPositions(jmg, positions);
+		goal->getCurrentStateNonConst().setJointGroupPositions(jmg, positions);
+		goal->getCurrentStateNonConst().update();
+		goals.push_back(goal);
+		jmgs.push_back(jmg);
+		jobs[planner_[i].second->concurrencyKey()].push_back(i);
+	}
+
+	std::vector<robot_trajectory::RobotTrajectoryPtr> trajectories(planner_.size());
+	std::vector<char> successes(planner_.size(), false);
+	const std::atomic<bool>* cancel = cancellation::current();
+	std::vector<std::future<void>> workers;
+	for (const auto& job : jobs)
+		workers.push_back(std::async(std::launch::async, [&, indices = job.second, cancel]() {
+			cancellation::Scope scope(cancel);
+			// groups sharing a planner (or pipeline) are planned serially: split the time budget between them
+			const auto start_time = std::chrono::steady_clock::now();
+			for (size_t k = 0; k < indices.size(); ++k) {
+				const size_t i = indices[k];
+				double remaining =
+				    timeout - std::chrono::duration<double>(std::chrono::steady_clock::now() - start_time).count();
+				if (remaining <= 0.0)
+					break;
+				remaining /= indices.size() - k;
+				successes[i] =
+				    planner_[i].second->plan(start, goals[i], jmgs[i], remaining, trajectories[i], path_constraints);
+				if (!successes[i])
+					break;  // parallel planning failed anyway
+			}
+		}));
+	for (auto& worker : workers)
+		worker.get();
+
+	if (successes.front())
+		first = trajectories.front();
+	if (std::find(successes.begin(), successes.end(), false) != successes.end())
+		return false;
+
+	// merge and validate
+	std::vector<robot_trajectory::RobotTrajectoryConstPtr> sub_trajectories(trajectories.begin(), trajectories.end());
+	SubTrajectoryPtr solution = merge(sub_trajectories, { start }, start->getCurrentState());
+	if (!solution)
+		return false;
+	connect(from, to, solution);
+	return true;
+}
+
+Connecting::StatePairList Connect::computeGroup(const StatePairList& pairs) {
+	if (planner_.size() != 1)  // multi-goal planning only supported for a single group
+		return Connecting::computeGroup(pairs);
+
+	const auto& props = properties();
+	MergeMode mode = props.get<MergeMode>("merge_mode");
+	const auto& path_constraints = props.get<moveit_msgs::Constraints>("path_constraints");
+
+	// all pairs share either their start or their end state: plan from the shared one (backwards in the latter case)
+	const bool backward = pairs.front().first != pairs.back().first;
+	const InterfaceState& shared = backward ? *pairs.front().second : *pairs.front().first;
+	const planning_scene::PlanningSceneConstPtr& start = shared.scene();
+	const moveit::core::JointModelGroup* jmg = start->getRobotModel()->getJointModelGroup(planner_.front().first);
+
+	std::vector<planning_scene::PlanningSceneConstPtr> goals;
+	std::vector<double> positions;
+	for (const auto& pair : pairs) {
+		const InterfaceState& other = backward ? *pair.first : *pair.second;
+		planning_scene::PlanningScenePtr goal = start->diff();
+		other.scene()->getCurrentState().copyJointGroupPositions(jmg, positions);
+		goal->getCurrentStateNonConst().setJointGroupPositions(jmg, positions);
+		goal->getCurrentStateNonConst().update();
+		goals.push_back(goal);
+	}
+
+	robot_trajectory::RobotTrajectoryPtr trajectory;
+	size_t reached = 0;
+	bool success = planner_.front().second->plan(start, goals, jmg, timeout(), trajectory, reached, path_constraints);
+
+	// a single hard goal might fail the whole request: plan for each pair individually
+	if (!success)
+		return pairs;
+
+	const InterfaceState& from = *pairs[reached].first;
+	const InterfaceState& to = *pairs[reached].second;
+	if (backward)
+		trajectory->reverse();
+	std::vector<planning_scene::PlanningSceneConstPtr> scenes{ backward ? goals[reached] : start,
+		                                                        backward ? start : goals[reached] };
+
+	SolutionBasePtr solution;
+	if (mode != SEQUENTIAL)
+		solution = merge({ trajectory }, scenes, from.scene()->getCurrentState());
+	if (!solution)
+		solution = makeSequential({ trajectory }, scenes, from, to);
+	connect(from, to, solution);
+
+	// remaining pairs were not tried individually: queue them again
+	StatePairList unreached(pairs);
+	unreached.erase(unreached.begin() + reached);
+	return unreached;
+}
+
 SolutionSequencePtr
 Connect::makeSequential(const std::vector<robot_trajectory::RobotTrajectoryConstPtr>& sub_trajectories,
                         const std::vector<planning_scene::PlanningSceneConstPtr>& intermediate_scenes,
@@ -181,20 +314,16 @@ Connect::makeSequential(const std::vector<robot_trajectory::RobotTrajectoryConst
 	planning_scene::PlanningSceneConstPtr start_ps = *scene_it;
 	const InterfaceState* state = &from;
 
-	// calculate cost
-	double cost = 0;
-	for (const auto& trajectory : sub_trajectories) {
-		if (!trajectory)
-			continue;
-		for (const double& distance : trajectory->getWayPointDurations())
-			cost += distance;
-	}
+	double cost = estimateDuration(sub_trajectories);
 
 	SolutionSequence::container_type sub_solutions;
+	auto planner_it = planner_.cbegin();
 	for (const auto& sub : sub_trajectories) {
 		planning_scene::PlanningSceneConstPtr end_ps = *++scene_it;
 
-		auto inserted = subsolutions_.insert(subsolutions_.end(), SubTrajectory(sub));
+		auto inserted = subsolutions_.insert(subsolutions_.end(), SubTrajectory());
+		// sub trajectories were planned by the planners in order
+		inserted->setTrajectory(sub, (planner_it++)->second->deferredTiming());
 		inserted->setCreator(pimpl_);
 		// push back solution pointer
 		sub_solutions.push_back(&*inserted);
@@ -215,25 +344,35 @@ Connect::makeSequential(const std::vector<robot_trajectory::RobotTrajectoryConst
 	return std::make_shared<SolutionSequence>(std::move(sub_solutions), cost);
 }
 
+double Connect::estimateDuration(const std::vector<robot_trajectory::RobotTrajectoryConstPtr>& sub_trajectories) const {
+	double duration = 0.0;
+	auto planner_it = planner_.cbegin();
+	for (const auto& trajectory : sub_trajectories) {
+		// respect the planner's velocity scaling for not yet timed trajectories
+		const auto& planner = (planner_it++)->second;
+		if (trajectory)
+			duration += planner->estimateDuration(*trajectory);
+	}
+	return duration;
+}
+
 SubTrajectoryPtr Connect::merge(const std::vector<robot_trajectory::RobotTrajectoryConstPtr>& sub_trajectories,
                                 const std::vector<planning_scene::PlanningSceneConstPtr>& intermediate_scenes,
                                 const moveit::core::RobotState& state) {
-	// calculate cost
-	double cost = 0;
-	for (const auto& trajectory : sub_trajectories) {
-		if (!trajectory)
-			continue;
-		for (const double& distance : trajectory->getWayPointDurations())
-			cost += distance;
-	}
+	double cost = estimateDuration(sub_trajectories);
 
 	// no need to merge if there is only a single sub trajectory
-	if (sub_trajectories.size() == 1)
-		return std::make_shared<SubTrajectory>(sub_trajectories[0], cost);
+	if (sub_trajectories.size() == 1) {
+		auto solution = std::make_shared<SubTrajectory>();
+		solution->setTrajectory(sub_trajectories[0], planner_.front().second->deferredTiming());
+		solution->setCost(cost);
+		return solution;
+	}
 
 	auto jmg = merged_jmg_.get();
 	assert(jmg);
-	robot_trajectory::RobotTrajectoryPtr trajectory = task_constructor::merge(sub_trajectories, state, jmg);
+	// timing is deferred until the solution is used
+	robot_trajectory::RobotTrajectoryPtr trajectory = task_constructor::merge(sub_trajectories, state, jmg, false);
 	if (!trajectory)
 		return SubTrajectoryPtr();
 
@@ -242,7 +381,11 @@ SubTrajectoryPtr Connect::merge(const std::vector<robot_trajectory::RobotTraject
 	                                              properties().get<moveit_msgs::Constraints>("path_constraints")))
 		return SubTrajectoryPtr();
 
-	return std::make_shared<SubTrajectory>(trajectory, cost);
+	// merged trajectory is timed when used, at full speed
+	auto solution = std::make_shared<SubTrajectory>();
+	solution->setTrajectory(trajectory, [](robot_trajectory::RobotTrajectory& t) { computeTimeStamps(t); });
+	solution->setCost(cost);
+	return solution;
 }
 }  // namespace stages
 }  // namespace task_constructor
@@ -60,12 +60,14 @@ FixCollisionObjects::FixCollisionObjects(const std::string& name) : PropagatingE
 
 void FixCollisionObjects::computeForward(const InterfaceState& from) {
 	planning_scene::PlanningScenePtr to = from.scene()->diff();
-	sendForward(from, InterfaceState(to), fixCollisions(*to));
+	SubTrajectory solution = fixCollisions(*to);  // before creating the state, which might replace the scene
+	sendForward(from, InterfaceState(to), std::move(solution));
 }
 
 void FixCollisionObjects::computeBackward(const InterfaceState& to) {
 	planning_scene::PlanningScenePtr from = to.scene()->diff();
-	sendBackward(InterfaceState(from), to, fixCollisions(*from));
+	SubTrajectory solution = fixCollisions(*from);
+	sendBackward(InterfaceState(from), to, std::move(solution));
 }
 
 bool computeCorrection(const std::vector<cd::Contact>& contacts, Eigen::Vector3d& correction, double max_penetration) {
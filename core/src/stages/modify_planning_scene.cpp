@@ -117,7 +117,6 @@ void ModifyPlanningScene::allowCollisions(planning_scene::PlanningScene& scene,
 // as well as to forbid instead of allow collision (and vice versa)
 InterfaceState ModifyPlanningScene::apply(const InterfaceState& from, bool invert) {
 	planning_scene::PlanningScenePtr scene = from.scene()->diff();
-	InterfaceState result(scene);
 	// add/remove objects
 	for (const auto& collision_object : collision_objects_)
 		processCollisionObject(*scene, collision_object);
@@ -133,7 +132,8 @@ InterfaceState ModifyPlanningScene::apply(const InterfaceState& from, bool inver
 	if (callback_)
 		callback_(scene, properties());
 
-	return result;
+	// create the state only now: interning replaces the scene passed
+	return InterfaceState(scene);
 }
 
 void ModifyPlanningScene::processCollisionObject(planning_scene::PlanningScene& scene,
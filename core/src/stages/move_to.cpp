@@ -238,14 +238,10 @@ bool MoveTo::compute(const InterfaceState& state, planning_scene::PlanningSceneP
 		scene->setCurrentState(robot_trajectory->getLastWayPoint());
 		if (dir == BACKWARD)
 			robot_trajectory->reverse();
-		solution.setTrajectory(robot_trajectory);
+		solution.setTrajectory(robot_trajectory, planner_->deferredTiming());
 
-		// set cost
-		double cost = 0;
-		for (const double& distance : robot_trajectory->getWayPointDurations()) {
-			cost += distance;
-		}
-		solution.setCost(cost);
+		// set cost, estimating duration of not yet timed trajectories
+		solution.setCost(planner_->estimateDuration(*robot_trajectory));
 
 		if (!success)
 			solution.markAsFailure();
@@ -41,7 +41,12 @@
 #include <moveit/robot_trajectory/robot_trajectory.h>
 #include <moveit/robot_state/conversions.h>
 #include <moveit/planning_scene/planning_scene.h>
+#include <geometric_shapes/shapes.h>
 #include <assert.h>
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+#include <unordered_map>
 
 namespace moveit {
 namespace task_constructor {
@@ -53,15 +58,296 @@ const planning_scene::PlanningScenePtr& ensureUpdated(const planning_scene::Plan
 	return scene;
 }
 
-InterfaceState::InterfaceState(const planning_scene::PlanningScenePtr& ps) : scene_(ensureUpdated(ps)) {}
+namespace {
+std::atomic<size_t> NUM_FLATTENED_SCENES{ 0 };
+
+// number of parent scenes traversed by lookups of robot state, ACM, and transforms
+unsigned int lookupCost(const planning_scene::PlanningScene& scene) {
+	// diff scenes refer to their parent for all entries not (yet) modified
+	const moveit::core::RobotState* state = &scene.getCurrentState();
+	const collision_detection::AllowedCollisionMatrix* acm = &scene.getAllowedCollisionMatrix();
+	const moveit::core::Transforms* transforms = &scene.getTransforms();
+	unsigned int cost = 0;
+	for (const planning_scene::PlanningScene* p = scene.getParent().get(); p && (state || acm || transforms);
+	     p = p->getParent().get()) {
+		state = state == &p->getCurrentState() ? (++cost, state) : nullptr;
+		acm = acm == &p->getAllowedCollisionMatrix() ? (++cost, acm) : nullptr;
+		transforms = transforms == &p->getTransforms() ? (++cost, transforms) : nullptr;
+	}
+	return cost;
+}
+
+bool exceedsLimits(const planning_scene::PlanningScene& scene, const InterfaceState::SceneFlattening& policy) {
+	if (policy.max_depth > 0) {
+		unsigned int depth = 0;
+		for (const planning_scene::PlanningScene* p = scene.getParent().get(); p; p = p->getParent().get())
+			if (++depth > policy.max_depth)
+				return true;
+	}
+	return policy.max_lookup_cost > 0 && lookupCost(scene) > policy.max_lookup_cost;
+}
+
+// diff of scene w.r.t. its parent, to be published instead of the diff of a replacing scene
+std::shared_ptr<const moveit_msgs::PlanningScene> diffMsg(const planning_scene::PlanningScene& scene) {
+	auto msg = std::make_shared<moveit_msgs::PlanningScene>();
+	scene.getPlanningSceneDiffMsg(*msg);
+	return msg;
+}
+
+// decoupling loses the diff w.r.t. the parent: keep it in diff (if not yet known)
+planning_scene::PlanningSceneConstPtr flatten(const planning_scene::PlanningSceneConstPtr& scene,
+                                              const InterfaceState::SceneFlattening& policy,
+                                              std::shared_ptr<const moveit_msgs::PlanningScene>& diff) {
+	if (!policy.enabled() || !exceedsLimits(*scene, policy))
+		return scene;
+	if (!diff)
+		diff = diffMsg(*scene);
+	// scene might be shared: decouple a diff instead of modifying it in place
+	planning_scene::PlanningScenePtr flat = scene->diff();
+	flat->decoupleParent();
+	++NUM_FLATTENED_SCENES;
+	return flat;
+}
+
+std::atomic<bool> SCENE_INTERNING{ false };
+std::atomic<size_t> NUM_INTERNED_SCENES{ 0 };
+std::mutex INTERNED_SCENES_MUTEX;
+// base scenes indexed by their collision environment key
+std::unordered_map<std::string, std::weak_ptr<const planning_scene::PlanningScene>> INTERNED_SCENES;
+size_t INTERNED_SCENES_SWEEP_SIZE = 64;  // sweep expired entries when reaching this size
+
+template <typename T>
+void appendRaw(std::string& key, const T& value) {
+	key.append(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+void appendString(std::string& key, const std::string& s) {
+	key.append(s).push_back('\0');
+}
+void appendPose(std::string& key, const Eigen::Isometry3d& pose) {
+	key.append(reinterpret_cast<const char*>(pose.matrix().data()), 16 * sizeof(double));
+}
+// primitive shapes are described by their dimensions, others (meshes, octrees) by identity
+void appendShape(std::string& key, const shapes::ShapeConstPtr& shape) {
+	appendRaw(key, shape->type);
+	switch (shape->type) {
+		case shapes::SPHERE:
+			appendRaw(key, static_cast<const shapes::Sphere&>(*shape).radius);
+			break;
+		case shapes::BOX:
+			appendRaw(key, static_cast<const shapes::Box&>(*shape).size);
+			break;
+		case shapes::CYLINDER:
+			appendRaw(key, static_cast<const shapes::Cylinder&>(*shape).radius);
+			appendRaw(key, static_cast<const shapes::Cylinder&>(*shape).length);
+			break;
+		case shapes::CONE:
+			appendRaw(key, static_cast<const shapes::Cone&>(*shape).radius);
+			appendRaw(key, static_cast<const shapes::Cone&>(*shape).length);
+			break;
+		default:
+			appendRaw(key, shape.get());
+	}
+}
+
+// exact key describing the collision environment of a scene
+std::string environmentKey(const planning_scene::PlanningScene& scene) {
+	std::string key;
+	for (const auto& pair : *scene.getWorld()) {  // map: sorted by id
+		appendString(key, pair.first);
+		const collision_detection::World::Object& object = *pair.second;
+		for (size_t i = 0; i < object.shapes_.size(); ++i) {
+			appendShape(key, object.shapes_[i]);
+			appendPose(key, object.shape_poses_[i]);
+		}
+		if (scene.hasObjectColor(pair.first)) {
+			const std_msgs::ColorRGBA& color = scene.getObjectColor(pair.first);
+			for (float c : { color.r, color.g, color.b, color.a })
+				appendRaw(key, c);
+		}
+	}
+	key.push_back('\0');
+
+	const collision_detection::AllowedCollisionMatrix& acm = scene.getAllowedCollisionMatrix();
+	std::vector<std::string> names;
+	acm.getAllEntryNames(names);
+	collision_detection::AllowedCollision::Type type;
+	for (auto first = names.cbegin(); first != names.cend(); ++first) {
+		appendString(key, *first);
+		appendRaw(key, acm.getDefaultEntry(*first, type) ? static_cast<char>(type) : '-');
+		for (auto second = first; second != names.cend(); ++second)
+			appendRaw(key, acm.getEntry(*first, *second, type) ? static_cast<char>(type) : '-');
+	}
+	key.push_back('\0');
+
+	std::vector<const moveit::core::AttachedBody*> bodies;
+	scene.getCurrentState().getAttachedBodies(bodies);
+	std::sort(bodies.begin(), bodies.end(),
+	          [](const moveit::core::AttachedBody* a, const moveit::core::AttachedBody* b) {
+		          return a->getName() < b->getName();
+	          });
+	for (const moveit::core::AttachedBody* body : bodies) {
+		appendString(key, body->getName());
+		appendString(key, body->getAttachedLinkName());
+		for (size_t i = 0; i < body->getShapes().size(); ++i) {
+			appendShape(key, body->getShapes()[i]);
+			appendPose(key, body->getFixedTransforms()[i]);
+		}
+		for (const std::string& link : body->getTouchLinks())
+			appendString(key, link);
+	}
+	return key;
+}
+
+planning_scene::PlanningScenePtr intern(const planning_scene::PlanningSceneConstPtr& scene) {
+	const std::string key = environmentKey(*scene);
+	planning_scene::PlanningSceneConstPtr base;
+	{
+		std::lock_guard<std::mutex> lock(INTERNED_SCENES_MUTEX);
+		std::weak_ptr<const planning_scene::PlanningScene>& entry = INTERNED_SCENES[key];
+		base = entry.lock();
+		if (base)
+			++NUM_INTERNED_SCENES;
+		else {
+			planning_scene::PlanningScenePtr flat = scene->diff();
+			flat->decoupleParent();
+			entry = base = flat;
+
+			if (INTERNED_SCENES.size() >= INTERNED_SCENES_SWEEP_SIZE) {
+				for (auto it = INTERNED_SCENES.begin(); it != INTERNED_SCENES.end();)
+					it = it->second.expired() ? INTERNED_SCENES.erase(it) : std::next(it);
+				INTERNED_SCENES_SWEEP_SIZE = std::max<size_t>(64, 2 * INTERNED_SCENES.size());
+			}
+		}
+	}
+	// only override robot state
+	planning_scene::PlanningScenePtr result = base->diff();
+	result->setCurrentState(scene->getCurrentState());
+	return result;
+}
+}  // namespace
+
+std::string environmentFingerprint(const planning_scene::PlanningScene& scene) {
+	return environmentKey(scene);
+}
+
+std::string sceneFingerprint(const planning_scene::PlanningScene& scene) {
+	std::string key = environmentKey(scene);
+	const moveit::core::RobotState& state = scene.getCurrentState();
+	key.append(reinterpret_cast<const char*>(state.getVariablePositions()), state.getVariableCount() * sizeof(double));
+	return key;
+}
+
+void InterfaceState::setSceneInterning(bool enable) {
+	SCENE_INTERNING = enable;
+}
+
+bool InterfaceState::sceneInterning() {
+	return SCENE_INTERNING;
+}
+
+size_t InterfaceState::numInternedScenes() {
+	return NUM_INTERNED_SCENES;
+}
+
+size_t InterfaceState::numFlattenedScenes() {
+	return NUM_FLATTENED_SCENES;
+}
+
+// apply interning to a new scene, keeping its original diff in diff
+static planning_scene::PlanningSceneConstPtr prepareScene(const planning_scene::PlanningScenePtr& ps,
+                                                         std::shared_ptr<const moveit_msgs::PlanningScene>& diff) {
+	if (!SCENE_INTERNING)
+		return ensureUpdated(ps);
+	diff = diffMsg(*ensureUpdated(ps));
+	return ensureUpdated(intern(ps));
+}
+
+struct InterfaceState::LazyScene
+{
+	planning_scene::PlanningSceneConstPtr parent;
+	const moveit::core::JointModelGroup* group;
+	std::vector<double> joint_values;
+	SceneDelta delta;
+	SceneFlattening flattening;  // applied on creation
+	planning_scene::PlanningSceneConstPtr scene;  // created scene
+	std::shared_ptr<const moveit_msgs::PlanningScene> diff;  // original diff of a replaced scene
+	std::once_flag created;  // copies might be materialized concurrently
+	std::atomic<bool> materialized{ false };  // scene and diff are valid (without calling created)
+};
+
+InterfaceState::InterfaceState(const planning_scene::PlanningScenePtr& ps) {
+	scene_ = prepareScene(ps, scene_diff_);
+}
 
 InterfaceState::InterfaceState(const planning_scene::PlanningSceneConstPtr& ps) : scene_(ps) {
 	if (scene_->getCurrentState().dirty())
 		ROS_ERROR_NAMED("InterfaceState", "Dirty PlanningScene! Please only forward clean ones into InterfaceState.");
+	if (SCENE_INTERNING) {
+		scene_diff_ = diffMsg(*ps);
+		scene_ = intern(ps);
+	}
+}
+
+InterfaceState::InterfaceState(const planning_scene::PlanningSceneConstPtr& parent,
+                               const moveit::core::JointModelGroup* group, const std::vector<double>& joint_values,
+                               const SceneDelta& delta)
+  : lazy_scene_(new LazyScene{ parent, group, joint_values, delta, {}, nullptr, nullptr, {} }) {
+	assert(parent);
+	assert(!group || group->getVariableCount() == joint_values.size());
 }
 
 InterfaceState::InterfaceState(const InterfaceState& other)
-  : scene_(other.scene_), properties_(other.properties_), priority_(other.priority_) {}
+  : scene_(other.scene_)
+  , scene_diff_(other.scene_diff_)
+  , lazy_scene_(other.lazy_scene_)
+  , properties_(other.properties_)
+  , priority_(other.priority_) {}
+
+const planning_scene::PlanningSceneConstPtr& InterfaceState::materialize() const {
+	assert(lazy_scene_);
+	LazyScene& lazy = *lazy_scene_;
+	std::call_once(lazy.created, [&lazy] {  // not yet created by a copy of this state
+		planning_scene::PlanningScenePtr scene = lazy.parent->diff();
+		if (lazy.group)
+			scene->getCurrentStateNonConst().setJointGroupPositions(lazy.group, lazy.joint_values);
+		if (lazy.delta)
+			lazy.delta(*scene);
+		lazy.scene = flatten(prepareScene(scene, lazy.diff), lazy.flattening, lazy.diff);
+		// release recipe data
+		lazy.parent.reset();
+		lazy.delta = SceneDelta();
+		std::vector<double>().swap(lazy.joint_values);
+		lazy.materialized = true;
+	});
+	// not cached in scene_: copies are used from multiple threads
+	return lazy.scene;
+}
+
+bool InterfaceState::sceneMaterialized() const {
+	return scene_ || (lazy_scene_ && lazy_scene_->materialized);
+}
+
+void InterfaceState::getSceneDiffMsg(moveit_msgs::PlanningScene& msg) const {
+	const planning_scene::PlanningSceneConstPtr& current = scene();  // create lazy scene
+	const auto& diff = scene_diff_ ? scene_diff_ : lazy_scene_ ? lazy_scene_->diff : nullptr;
+	if (diff)
+		msg = *diff;
+	else
+		current->getPlanningSceneDiffMsg(msg);
+}
+
+void InterfaceState::flattenScene(const SceneFlattening& policy) {
+	if (!policy.enabled() || !hasScene())
+		return;
+	if (!sceneMaterialized())  // not yet created: apply on creation
+		lazy_scene_->flattening = policy;
+	else {
+		const planning_scene::PlanningSceneConstPtr& current = scene();
+		if (!scene_diff_ && lazy_scene_)
+			scene_diff_ = lazy_scene_->diff;
+		scene_ = flatten(current, policy, scene_diff_);
+	}
+}
 
 bool InterfaceState::Priority::operator<(const InterfaceState::Priority& other) const {
 	// infinite costs go always last
@@ -82,8 +368,8 @@ Interface::Interface(const Interface::NotifyFunction& notify) : notify_(notify)
 
 // Announce a new InterfaceState
 void Interface::add(InterfaceState& state) {
-	// require valid scene
-	assert(state.scene());
+	// require valid (but possibly not yet created) scene
+	assert(state.hasScene());
 	// incoming and outgoing must not contain elements both
 	assert(state.incomingTrajectories().empty() || state.outgoingTrajectories().empty());
 	// if non-empty, incoming or outgoing should have exactly one solution element
@@ -105,6 +391,12 @@ void Interface::add(InterfaceState& state) {
 	else  // otherwise, assume priority was well defined before
 		assert(it->priority_ >= InterfaceState::Priority(1, 0.0));
 
+	// reject states that cannot become part of a solution better than the cost bound
+	if (it->priority_.cost() > cost_bound_) {
+		it->owner_ = nullptr;
+		return;
+	}
+
 	// move list node into interface's state list (sorted by priority)
 	moveFrom(it, container);
 	// and finally call notify callback
@@ -119,6 +411,24 @@ Interface::container_type Interface::remove(iterator it) {
 	return result;
 }
 
+Interface::container_type Interface::prune(double bound) {
+	cost_bound_ = bound;
+	container_type result;
+	for (iterator it = begin(), end = this->end(); it != end;) {
+		iterator cur = it++;
+		if (cur->priority().cost() > bound) {
+			cur->owner_ = nullptr;
+			moveTo(cur, result, result.end());
+		}
+	}
+	return result;
+}
+
+void Interface::clear() {
+	base_type::clear();
+	cost_bound_ = std::numeric_limits<double>::infinity();
+}
+
 void Interface::updatePriority(InterfaceState* state, const InterfaceState::Priority& priority) {
 	if (priority != state->priority()) {
 		auto it = std::find_if(begin(), end(), [state](const InterfaceState* other) { return state == other; });
@@ -131,6 +441,17 @@ void Interface::updatePriority(InterfaceState* state, const InterfaceState::Prio
 	}
 }
 
+void SolutionBase::detachStates() {
+	auto remove = [this](InterfaceState::Solutions& list) {
+		list.erase(std::remove(list.begin(), list.end(), this), list.end());
+	};
+	if (start_)
+		remove(const_cast<InterfaceState*>(start_)->outgoing_trajectories_);
+	if (end_)
+		remove(const_cast<InterfaceState*>(end_)->incoming_trajectories_);
+	start_ = end_ = nullptr;
+}
+
 void SolutionBase::setCreator(StagePrivate* creator) {
 	assert(creator_ == nullptr || creator_ == creator);  // creator must only set once
 	creator_ = creator;
@@ -152,15 +473,43 @@ void SolutionBase::fillInfo(moveit_task_constructor_msgs::SolutionInfo& info, In
 	std::copy(markers.begin(), markers.end(), info.markers.begin());
 }
 
+struct SubTrajectory::DeferredTiming
+{
+	TimingFunction timing;
+	std::once_flag once;
+	robot_trajectory::RobotTrajectoryConstPtr timed;
+};
+
+void SubTrajectory::setTrajectory(const robot_trajectory::RobotTrajectoryConstPtr& t, TimingFunction timing) {
+	trajectory_ = t;
+	timing_.reset();
+	if (t && timing) {
+		timing_ = std::make_shared<DeferredTiming>();
+		timing_->timing = std::move(timing);
+	}
+}
+
+robot_trajectory::RobotTrajectoryConstPtr SubTrajectory::timedTrajectory() const {
+	if (!trajectory_ || !timing_)
+		return trajectory_;
+	// time a copy: the untimed trajectory might be read concurrently (e.g. by Merger)
+	std::call_once(timing_->once, [this]() {
+		auto timed = std::make_shared<robot_trajectory::RobotTrajectory>(*trajectory_, true);
+		timing_->timing(*timed);
+		timing_->timed = timed;
+	});
+	return timing_->timed;
+}
+
 void SubTrajectory::fillMessage(moveit_task_constructor_msgs::Solution& msg, Introspection* introspection) const {
 	msg.sub_trajectory.emplace_back();
 	moveit_task_constructor_msgs::SubTrajectory& t = msg.sub_trajectory.back();
 	SolutionBase::fillInfo(t.info, introspection);
 
-	if (trajectory())
-		trajectory()->getRobotTrajectoryMsg(t.trajectory);
+	if (auto trajectory = timedTrajectory())
+		trajectory->getRobotTrajectoryMsg(t.trajectory);
 
-	this->end()->scene()->getPlanningSceneDiffMsg(t.scene_diff);
+	this->end()->getSceneDiffMsg(t.scene_diff);
 }
 
 void SolutionSequence::push_back(const SolutionBase& solution) {
@@ -37,7 +37,9 @@
 
 #include <moveit/task_constructor/container_p.h>
 #include <moveit/task_constructor/task_p.h>
+#include <moveit/task_constructor/cancellation.h>
 #include <moveit/task_constructor/introspection.h>
+#include <moveit/task_constructor/trace.h>
 #include <moveit_task_constructor_msgs/ExecuteTaskSolutionAction.h>
 
 #include <ros/ros.h>
@@ -47,6 +49,7 @@
 #include <moveit/planning_pipeline/planning_pipeline.h>
 
 #include <functional>
+#include <future>
 
 namespace {
 std::string rosNormalizeName(const std::string& name) {
@@ -104,6 +107,52 @@ const ContainerBase* TaskPrivate::stages() const {
 	return children().empty() ? nullptr : static_cast<ContainerBase*>(children().front().get());
 }
 
+void TaskPrivate::pruneDominated(size_t k) {
+	const auto& solutions = stages()->solutions();
+	if (k == 0 || solutions.size() < k)
+		return;
+
+	// cost of k-th best solution
+	double bound = (*std::next(solutions.begin(), k - 1))->cost();
+	if (bound >= pruning_bound_)
+		return;  // nothing changed since last pruning
+	pruning_bound_ = bound;
+	children().front()->pimpl()->pruneStates(bound);
+}
+
+namespace {
+// collect solution and all its sub solutions
+void collectSolutions(const SolutionBase* solution, std::set<const SolutionBase*>& result) {
+	if (!result.insert(solution).second)
+		return;
+	if (auto sequence = dynamic_cast<const SolutionSequence*>(solution)) {
+		for (const SolutionBase* sub : sequence->solutions())
+			collectSolutions(sub, result);
+	} else if (auto wrapped = dynamic_cast<const WrappedSolution*>(solution))
+		collectSolutions(wrapped->wrapped(), result);
+}
+}  // namespace
+
+void TaskPrivate::retainSolutions(size_t k) {
+	StagePrivate* container = children().front()->pimpl();
+	container->dropSolutions(k);
+
+	const auto& solutions = stages()->solutions();
+	if (solutions.size() < k)
+		return;
+
+	double bound = solutions.back()->cost();
+	if (bound >= retention_bound_)
+		return;  // nothing changed since last release
+	retention_bound_ = bound;
+
+	// sub solutions of retained solutions might have (almost) the same cost: explicitly keep them
+	std::set<const SolutionBase*> keep;
+	for (const auto& solution : solutions)
+		collectSolutions(solution.get(), keep);
+	container->releaseSolutions(bound, keep);
+}
+
 Task::Task(const std::string& id, ContainerBase::pointer&& container)
   : WrapperBase(new TaskPrivate(this, id), std::move(container)) {
 	if (!id.empty())
@@ -158,6 +207,9 @@ planning_pipeline::PlanningPipelinePtr Task::createPlanner(const robot_model::Ro
                                                            const std::string& planning_plugin_param_name,
                                                            const std::string& adapter_plugins_param_name) {
 	static PlannerCache cache;
+	// tasks might be initialized concurrently
+	static std::mutex cache_mutex;
+	std::lock_guard<std::mutex> lock(cache_mutex);
 	PlannerCache::PlannerID id(ns, planning_plugin_param_name, adapter_plugins_param_name);
 
 	std::weak_ptr<planning_pipeline::PlanningPipeline>& entry = cache.retrieve(model, id);
@@ -174,6 +226,15 @@ planning_pipeline::PlanningPipelinePtr Task::createPlanner(const robot_model::Ro
 
 Task::~Task() {
 	auto impl = pimpl();
+	// stop any (asynchronous) planning and wait for it to finish
+	impl->preempt();
+	{
+		std::lock_guard<std::mutex> lock(impl->async_runs_mutex_);
+		for (auto& run : impl->async_runs_)
+			run.wait();
+	}
+	std::lock_guard<std::mutex> planning_lock(impl->planning_mutex_);
+
 	clear();  // remove all stages
 	impl->robot_model_.reset();
 	// only destroy loader after all references to the model are gone!
@@ -288,28 +349,114 @@ bool Task::canCompute() const {
 }
 
 void Task::compute() {
+	stages()->pimpl()->setDeadline(pimpl()->deadline_);
 	stages()->pimpl()->runCompute();
 }
 
-bool Task::plan(size_t max_solutions) {
+bool Task::plan(size_t max_solutions, double timeout) {
+	return planLoop(max_solutions, timeout, pimpl()->preempt_requests_);
+}
+
+std::future<bool> Task::planAsync(size_t max_solutions, double timeout) {
 	auto impl = pimpl();
-	init();
-
-	impl->preempt_requested_ = false;
-	while (ros::ok() && !impl->preempt_requested_ && canCompute() &&
-	       (max_solutions == 0 || numSolutions() < max_solutions)) {
-		compute();
-		for (const auto& cb : impl->task_cbs_)
-			cb(*this);
-		if (impl->introspection_)
-			impl->introspection_->publishTaskState();
-	}
+	// preempt requests issued from now on concern the new run, such that an immediate preempt() isn't lost
+	size_t preempt_requests = impl->preempt_requests_;
+	std::promise<bool> promise;
+	std::future<bool> result = promise.get_future();
+	auto run = [this, max_solutions, timeout, preempt_requests, promise = std::move(promise)]() mutable {
+		try {
+			promise.set_value(planLoop(max_solutions, timeout, preempt_requests));
+		} catch (...) {
+			promise.set_exception(std::current_exception());
+		}
+	};
+
+	std::lock_guard<std::mutex> lock(impl->async_runs_mutex_);
+	// forget finished runs
+	impl->async_runs_.remove_if([](const std::future<void>& run) {
+		return run.wait_for(std::chrono::seconds(0)) == std::future_status::ready;
+	});
+	impl->async_runs_.push_back(std::async(std::launch::async, std::move(run)));
+	return result;
+}
+
+void TaskPrivate::startPlanning(size_t max_solutions, double timeout) {
+	// start the clock before init(), which already counts towards the budget
+	anytime_ = timeout > 0.0;
+	max_solutions_ = max_solutions;
+	deadline_ = std::chrono::steady_clock::time_point::max();
+	pruning_bound_ = std::numeric_limits<double>::infinity();
+	retention_bound_ = std::numeric_limits<double>::infinity();
+	if (anytime_)
+		deadline_ = std::chrono::steady_clock::now() + std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+		                                                   std::chrono::duration<double>(timeout));
+
+	std::lock_guard<std::recursive_mutex> lock(compute_mutex_);
+	static_cast<Task*>(me())->init();
+	// lift cost bounds of previous planning
+	children().front()->pimpl()->pruneStates(pruning_bound_);
+}
+
+bool TaskPrivate::planStep() {
+	Task* task = static_cast<Task*>(me());
+	if (!ros::ok() || preempt_requested_)
+		return false;
+
+	// only lock for a single iteration to allow access to solutions in between
+	std::lock_guard<std::recursive_mutex> lock(compute_mutex_);
+	// allow planners to poll for preemption
+	cancellation::Scope cancellation(&preempt_requested_);
+	if (!task->canCompute())
+		return false;
+	if (anytime_ ? remainingTime() <= 0.0 : (max_solutions_ > 0 && task->numSolutions() >= max_solutions_))
+		return false;
+
+	task->compute();
+	// continuing beyond max_solutions, partial solutions worse than the max_solutions best ones are useless
+	if (anytime_)
+		pruneDominated(max_solutions_);
+	// never retain less solutions than requested
+	if (solution_retention_)
+		retainSolutions(std::max(solution_retention_, max_solutions_));
+	for (const auto& cb : task_cbs_)
+		cb(*task);
+	if (introspection_)
+		introspection_->publishTaskState();
+	return true;
+}
+
+bool Task::planLoop(size_t max_solutions, double timeout, size_t preempt_requests) {
+	auto impl = pimpl();
+	std::lock_guard<std::mutex> planning_lock(impl->planning_mutex_);
+	// only now, a previous run is finished: forget preempt requests aimed at it
+	if (impl->preempt_requests_ == preempt_requests)
+		impl->preempt_requested_ = false;
+	trace::Scope scope("plan", impl->id().c_str());
+
+	impl->startPlanning(max_solutions, timeout);
+	while (impl->planStep())
+		;
+
+	std::lock_guard<std::recursive_mutex> lock(impl->compute_mutex_);
 	printState();
 	return numSolutions() > 0;
 }
 
+void Task::setSolutionRetention(size_t k) {
+	pimpl()->solution_retention_ = k;
+}
+
+size_t Task::solutionRetention() const {
+	return pimpl()->solution_retention_;
+}
+
+void TaskPrivate::preempt() {
+	++preempt_requests_;
+	preempt_requested_ = true;
+}
+
 void Task::preempt() {
-	pimpl()->preempt_requested_ = true;
+	pimpl()->preempt();
 }
 
 moveit_msgs::MoveItErrorCodes Task::execute(const SolutionBase& s) {
@@ -317,12 +464,21 @@ moveit_msgs::MoveItErrorCodes Task::execute(const SolutionBase& s) {
 	ac.waitForServer();
 
 	moveit_task_constructor_msgs::ExecuteTaskSolutionGoal goal;
-	s.fillMessage(goal.solution, pimpl()->introspection_.get());
+	{  // planning might still continue in the background
+		std::lock_guard<std::recursive_mutex> lock(pimpl()->compute_mutex_);
+		s.fillMessage(goal.solution, pimpl()->introspection_.get());
+	}
 	ac.sendGoal(goal);
 	ac.waitForResult();
 	return ac.getResult()->error_code;
 }
 
+SolutionBaseConstPtr Task::bestSolution() const {
+	std::lock_guard<std::recursive_mutex> lock(pimpl()->compute_mutex_);
+	const auto& all = solutions();
+	return all.empty() ? SolutionBaseConstPtr() : all.front();
+}
+
 void Task::publishAllSolutions(bool wait) {
 	enableIntrospection(true);
 	pimpl()->introspection_->publishAllSolutions(wait);
@@ -365,5 +521,40 @@ const core::RobotModelConstPtr& Task::getRobotModel() const {
 void Task::printState(std::ostream& os) const {
 	os << *stages();
 }
+
+void Task::printMemoryUsage(std::ostream& os) const {
+	MemoryUsage total;
+	ContainerBase::StageCallback processor = [&os, &total](const Stage& stage, unsigned int depth) -> bool {
+		const MemoryUsage memory = stage.memoryUsage();
+		total += memory;
+		os << std::string(2 * depth, ' ') << *stage.pimpl() << " (" << memory.total() / 1024 << " KiB)" << std::endl;
+		return true;
+	};
+	stages()->traverseRecursively(processor);
+	os << "memory: " << total.total() / 1024 << " KiB (states " << total.states / 1024 << ", scenes "
+	   << total.scenes / 1024 << ", trajectories " << total.trajectories / 1024 << ", markers " << total.markers / 1024
+	   << ")" << std::endl;
+}
+
+TaskTemplate::TaskTemplate(Builder builder, const moveit::core::RobotModelConstPtr& robot_model)
+  : builder_(std::move(builder)), robot_model_(robot_model) {}
+
+void TaskTemplate::loadRobotModel(const std::string& robot_description) {
+	robot_model_loader_ = std::make_shared<robot_model_loader::RobotModelLoader>(robot_description);
+	robot_model_ = robot_model_loader_->getModel();
+	if (!robot_model_)
+		throw Exception("TaskTemplate failed to construct RobotModel");
+}
+
+Task TaskTemplate::instantiate(const std::string& id) const {
+	Task task(id);
+	if (robot_model_)
+		task.setRobotModel(robot_model_);
+	for (const auto& pair : properties_)
+		task.setProperty(pair.first, pair.second);
+	if (builder_)
+		builder_(task);
+	return task;
+}
 }  // namespace task_constructor
 }  // namespace moveit
@@ -0,0 +1,78 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2026, MoveIt Task Constructor contributors
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of the copyright holder nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+/* Time parameterization of trajectories, which may be deferred until a solution is used */
+
+#include <moveit/task_constructor/timing.h>
+#include <moveit/robot_trajectory/robot_trajectory.h>
+#include <moveit/trajectory_processing/iterative_time_parameterization.h>
+
+#include <algorithm>
+#include <cmath>
+
+namespace moveit {
+namespace task_constructor {
+
+void computeTimeStamps(robot_trajectory::RobotTrajectory& trajectory, double max_velocity_scaling_factor,
+                       double max_acceleration_scaling_factor) {
+	trajectory_processing::IterativeParabolicTimeParameterization timing;
+	timing.computeTimeStamps(trajectory, max_velocity_scaling_factor, max_acceleration_scaling_factor);
+}
+
+double estimateDuration(const robot_trajectory::RobotTrajectory& trajectory, double max_velocity_scaling_factor) {
+	double duration = trajectory.getDuration();
+	if (duration > 0.0 || trajectory.getWayPointCount() < 2 || !trajectory.getGroup())
+		return duration;
+
+	// each segment takes at least as long as its slowest joint moving at max velocity
+	const auto& joints = trajectory.getGroup()->getActiveJointModels();
+	for (size_t i = 1; i < trajectory.getWayPointCount(); ++i) {
+		const moveit::core::RobotState& a = trajectory.getWayPoint(i - 1);
+		const moveit::core::RobotState& b = trajectory.getWayPoint(i);
+		double segment = 0.0;
+		for (const moveit::core::JointModel* jm : joints) {
+			if (jm->getVariableCount() != 1)
+				continue;
+			const moveit::core::VariableBounds& bounds = jm->getVariableBounds()[0];
+			if (!bounds.velocity_bounded_ || bounds.max_velocity_ <= 0.0)
+				continue;
+			const double distance = jm->distance(a.getJointPositions(jm), b.getJointPositions(jm));
+			segment = std::max(segment, distance / (bounds.max_velocity_ * max_velocity_scaling_factor));
+		}
+		duration += segment;
+	}
+	return duration;
+}
+}  // namespace task_constructor
+}  // namespace moveit
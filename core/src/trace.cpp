@@ -0,0 +1,163 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2026, MoveIt Task Constructor contributors
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of the copyright holder nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+#include <moveit/task_constructor/trace.h>
+
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+
+namespace moveit {
+namespace task_constructor {
+namespace trace {
+
+struct Tracer::Event
+{
+	// 1 + index of the stored event, 0 while being written
+	std::atomic<uint64_t> seq{ 0 };
+	Phase phase;
+	const char* category;
+	char name[64];
+	uint32_t tid;
+	int64_t timestamp;  // ns since enable()
+};
+
+namespace {
+uint32_t threadId() {
+	static std::atomic<uint32_t> next_id{ 1 };
+	thread_local uint32_t id = next_id++;
+	return id;
+}
+
+void writeEscaped(std::ostream& os, const char* s) {
+	for (; *s; ++s) {
+		if (*s == '"' || *s == '\\')
+			os << '\\' << *s;
+		else if (static_cast<unsigned char>(*s) < 0x20)
+			os << ' ';
+		else
+			os << *s;
+	}
+}
+}  // namespace
+
+std::atomic<bool> Tracer::enabled_{ false };
+
+Tracer& Tracer::instance() {
+	static Tracer tracer;
+	return tracer;
+}
+
+void Tracer::enable(size_t capacity) {
+	enabled_ = false;
+	events_.reset(new Event[capacity]);
+	capacity_ = capacity;
+	next_ = 0;
+	start_ = std::chrono::steady_clock::now();
+	enabled_ = capacity > 0;
+}
+
+void Tracer::disable() {
+	enabled_ = false;
+}
+
+void Tracer::record(Phase phase, const char* category, const char* name) {
+	if (capacity_ == 0)
+		return;
+
+	const uint64_t index = next_.fetch_add(1, std::memory_order_relaxed);
+	Event& e = events_[index % capacity_];
+	// invalidate slot while writing, such that a concurrent dump() skips it
+	e.seq.store(0, std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_release);
+
+	e.phase = phase;
+	e.category = category;
+	std::strncpy(e.name, name, sizeof(e.name) - 1);
+	e.name[sizeof(e.name) - 1] = 0;
+	e.tid = threadId();
+	e.timestamp =
+	    std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start_).count();
+
+	e.seq.store(index + 1, std::memory_order_release);
+}
+
+void Tracer::dump(std::ostream& os) const {
+	std::ostringstream ss;
+	ss << std::fixed << std::setprecision(3) << "{\"traceEvents\":[";
+
+	const uint64_t end = next_.load(std::memory_order_acquire);
+	const uint64_t begin = end > capacity_ ? end - capacity_ : 0;
+	bool first = true;
+	for (uint64_t index = begin; index < end; ++index) {
+		const Event& e = events_[index % capacity_];
+		if (e.seq.load(std::memory_order_acquire) != index + 1)
+			continue;  // overwritten or still being written
+
+		// copy the event and drop it if it was overwritten meanwhile
+		const Phase phase = e.phase;
+		const char* category = e.category;
+		char name[sizeof(e.name)];
+		std::memcpy(name, e.name, sizeof(name));
+		name[sizeof(name) - 1] = 0;
+		const uint32_t tid = e.tid;
+		const int64_t timestamp = e.timestamp;
+		std::atomic_thread_fence(std::memory_order_acquire);
+		if (e.seq.load(std::memory_order_relaxed) != index + 1)
+			continue;
+
+		ss << (first ? "\n" : ",\n") << "{\"name\":\"";
+		writeEscaped(ss, name);
+		ss << "\",\"cat\":\"" << category << "\",\"ph\":\"" << static_cast<char>(phase)
+		   << "\",\"ts\":" << timestamp / 1000.0 << ",\"pid\":1,\"tid\":" << tid;
+		if (phase == INSTANT)
+			ss << ",\"s\":\"t\"";  // thread-scoped instant event
+		ss << "}";
+		first = false;
+	}
+	ss << "\n],\"displayTimeUnit\":\"ms\"}\n";
+	os << ss.str();
+}
+
+bool Tracer::dump(const std::string& filename) const {
+	std::ofstream file(filename);
+	if (!file)
+		return false;
+	dump(file);
+	return file.good();
+}
+}  // namespace trace
+}  // namespace task_constructor
+}  // namespace moveit
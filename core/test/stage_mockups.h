@@ -0,0 +1,56 @@
+#pragma once
+
+#include <moveit/task_constructor/stage.h>
+#include <moveit/planning_scene/planning_scene.h>
+
+#include <algorithm>
+#include <deque>
+#include <functional>
+#include <string>
+#include <vector>
+
+/** Generator spawning a state for each of the given costs, num_per_compute states per compute()
+ *
+ * Optionally, the scene of each state is derived from the initial one by modify (receiving the state's cost),
+ * and each compute() is logged by the stage's name.
+ */
+class SpawningGeneratorMockup : public moveit::task_constructor::Generator
+{
+public:
+	using SceneModifier = std::function<void(planning_scene::PlanningScene& scene, double cost)>;
+
+	SpawningGeneratorMockup(const std::vector<double>& costs, size_t num_per_compute = 1,
+	                        const std::string& name = "spawning generator")
+	  : Generator(name), costs_(costs.begin(), costs.end()), num_per_compute_(num_per_compute) {}
+
+	void setSceneModifier(const SceneModifier& modify) { modify_ = modify; }
+	void setLog(std::vector<std::string>* log) { log_ = log; }
+
+	void init(const moveit::core::RobotModelConstPtr& robot_model) override {
+		Generator::init(robot_model);
+		scene_ = std::make_shared<planning_scene::PlanningScene>(robot_model);
+	}
+	bool canCompute() const override { return !costs_.empty(); }
+	void compute() override {
+		if (log_)
+			log_->push_back(name());
+		for (size_t n = std::min(num_per_compute_, costs_.size()); n > 0; --n) {
+			const double cost = costs_.front();
+			costs_.pop_front();
+			if (!modify_) {
+				spawn(moveit::task_constructor::InterfaceState(scene_), cost);
+				continue;
+			}
+			planning_scene::PlanningScenePtr scene = scene_->diff();
+			modify_(*scene, cost);
+			spawn(moveit::task_constructor::InterfaceState(scene), cost);
+		}
+	}
+
+private:
+	std::deque<double> costs_;
+	size_t num_per_compute_;
+	SceneModifier modify_;
+	std::vector<std::string>* log_ = nullptr;
+	planning_scene::PlanningScenePtr scene_;
+};
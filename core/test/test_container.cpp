@@ -1,13 +1,23 @@
+#include <moveit/task_constructor/batch_planner.h>
+#include <moveit/task_constructor/cancellation.h>
 #include <moveit/task_constructor/container_p.h>
 #include <moveit/task_constructor/stage_p.h>
 #include <moveit/task_constructor/task_p.h>
+#include <moveit/task_constructor/trace.h>
 #include <moveit/task_constructor/stages/fixed_state.h>
 #include <moveit/planning_scene/planning_scene.h>
 #include <moveit/utils/robot_model_test_utils.h>
 
 #include "gtest_value_printers.h"
+#include "models.h"
+#include "stage_mockups.h"
 #include <gtest/gtest.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
 #include <initializer_list>
+#include <sstream>
+#include <thread>
 
 using namespace moveit::task_constructor;
 
@@ -693,3 +703,591 @@ TEST(Task, reuse) {
 		ADD_FAILURE() << "InitStageException:" << std::endl << e << t;
 	}
 }
+
+TEST(Task, planAsync) {
+	Task t("async");
+	t.setRobotModel(getModel());
+
+	auto ref = new stages::FixedState("fixed");
+	ref->setState(std::make_shared<planning_scene::PlanningScene>(t.getRobotModel()));
+	t.add(Stage::pointer(ref));
+
+	size_t num_reported = 0;
+	t.addSolutionCallback([&num_reported](const SolutionBase& /* s */) { ++num_reported; });
+
+	std::future<bool> result = t.planAsync();
+	EXPECT_TRUE(result.get());
+	EXPECT_EQ(num_reported, 1u);
+	ASSERT_TRUE(t.bestSolution());
+	EXPECT_EQ(t.bestSolution(), t.solutions().front());
+}
+
+TEST(Task, planAsyncPreempted) {
+	std::future<bool> preempted, destroyed;
+	{
+		Task t("async");
+		t.setRobotModel(getModel());
+		// generator that could compute forever
+		t.add(std::make_unique<GeneratorMockup>(std::numeric_limits<int>::max()));
+
+		// an immediate preempt() isn't lost, even if the thread didn't start yet
+		preempted = t.planAsync();
+		t.preempt();
+		// destruction waits for pending runs
+		destroyed = t.planAsync();
+	}
+	ASSERT_EQ(preempted.wait_for(std::chrono::seconds(0)), std::future_status::ready);
+	ASSERT_EQ(destroyed.wait_for(std::chrono::seconds(0)), std::future_status::ready);
+	EXPECT_FALSE(preempted.get());
+	EXPECT_FALSE(destroyed.get());
+}
+
+TEST(Task, timeout) {
+	Task t("timeout");
+	t.setRobotModel(getModel());
+	// generator that could compute forever
+	t.add(std::make_unique<GeneratorMockup>(std::numeric_limits<int>::max()));
+	std::vector<std::chrono::steady_clock::time_point> steps;
+	t.addTaskCallback([&steps](const Task& /*task*/) { steps.push_back(std::chrono::steady_clock::now()); });
+
+	auto start = std::chrono::steady_clock::now();
+	EXPECT_FALSE(t.plan(0, 0.1));
+	auto stop = std::chrono::steady_clock::now();
+
+	// planning uses the whole budget, but doesn't start new steps beyond the deadline
+	auto deadline = t.stages()->pimpl()->deadline();
+	EXPECT_GE(deadline, start + std::chrono::milliseconds(100));
+	EXPECT_GE(stop, deadline);
+	ASSERT_FALSE(steps.empty());
+	EXPECT_LE(std::count_if(steps.begin(), steps.end(), [deadline](const auto& step) { return step >= deadline; }), 1);
+}
+
+TEST(Task, sceneFlattening) {
+	Task t("flattening");
+	t.setRobotModel(getModel());
+	planning_scene::PlanningScenePtr scene = std::make_shared<planning_scene::PlanningScene>(t.getRobotModel());
+	for (int i = 0; i < 3; ++i)
+		scene = scene->diff();
+	auto fixed = new stages::FixedState("fixed");
+	fixed->setState(scene);
+	t.add(Stage::pointer(fixed));
+
+	// policy of the task is inherited by all stages
+	InterfaceState::SceneFlattening policy;
+	policy.max_depth = 2;
+	t.setSceneFlattening(policy);
+	ASSERT_TRUE(t.plan());
+	EXPECT_FALSE(fixed->solutions().front()->end()->scene()->getParent());
+
+	// unless configured for a stage
+	fixed->setSceneFlattening(InterfaceState::SceneFlattening());
+	ASSERT_TRUE(t.plan());
+	EXPECT_TRUE(fixed->solutions().front()->end()->scene()->getParent());
+}
+
+class TimeoutRecorder : public Generator
+{
+public:
+	std::vector<double> timeouts;
+	TimeoutRecorder() : Generator("timeout recorder " + std::to_string(++MOCK_ID)) { setTimeout(10.0); }
+	bool canCompute() const override { return true; }
+	void compute() override { timeouts.push_back(timeout()); }
+};
+
+TEST(Stage, deadline) {
+	TimeoutRecorder g;
+	auto impl = g.pimpl();
+
+	// the remaining time limits the timeout (bounded by the time actually passed, not by absolute windows)
+	auto start = std::chrono::steady_clock::now();
+	impl->setDeadline(start + std::chrono::seconds(5));
+	impl->runCompute();
+	double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	ASSERT_EQ(g.timeouts.size(), 1u);
+	EXPECT_LE(g.timeouts[0], 5.0);
+	EXPECT_GE(g.timeouts[0], 5.0 - elapsed);
+
+	// without any time left, computation is skipped and the timeout doesn't become zero (solver default)
+	impl->setDeadline(std::chrono::steady_clock::now() - std::chrono::seconds(1));
+	impl->runCompute();
+	EXPECT_EQ(g.timeouts.size(), 1u);
+	EXPECT_GT(g.timeout(), 0.0);
+}
+
+TEST(SerialContainer, deadline) {
+	SerialContainer container("serial");
+	auto first = std::make_unique<TimeoutRecorder>();
+	auto second = std::make_unique<TimeoutRecorder>();
+	auto& first_timeouts = first->timeouts;
+	auto& second_timeouts = second->timeouts;
+	container.add(std::move(first));
+	container.add(std::move(second));
+
+	// children of unknown compute time share the remaining time equally
+	auto start = std::chrono::steady_clock::now();
+	container.pimpl()->setDeadline(start + std::chrono::seconds(8));
+	container.pimpl()->runCompute();
+	double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	ASSERT_EQ(first_timeouts.size(), 1u);
+	ASSERT_EQ(second_timeouts.size(), 1u);
+	EXPECT_LE(first_timeouts[0], 4.0);
+	EXPECT_GE(first_timeouts[0], (8.0 - elapsed) / 2 - elapsed);
+	// time unused by the first child is passed on to the second one
+	EXPECT_GT(second_timeouts[0], first_timeouts[0]);
+	EXPECT_GE(second_timeouts[0], 8.0 - elapsed);
+}
+
+TEST(ContainerBase, schedulingPolicy) {
+	std::vector<std::string> computed;
+	class LoggingGenerator : public Generator
+	{
+		std::vector<std::string>& log_;
+		int runs_;
+
+	public:
+		LoggingGenerator(const std::string& name, int runs, std::vector<std::string>& log)
+		  : Generator(name), log_(log), runs_(runs) {}
+		bool canCompute() const override { return runs_ > 0; }
+		void compute() override {
+			--runs_;
+			log_.push_back(name());
+		}
+	};
+
+	Alternatives container("alternatives");
+	container.add(std::make_unique<LoggingGenerator>("a", 2, computed));
+	container.add(std::make_unique<LoggingGenerator>("b", 1, computed));
+	container.add(std::make_unique<LoggingGenerator>("c", 2, computed));
+
+	// by default, all children are computed in turn
+	container.compute();
+	EXPECT_EQ(computed, std::vector<std::string>({ "a", "b", "c" }));
+
+	// round robin computes a single child per call, skipping those that cannot compute anymore
+	container.setSchedulingPolicy(std::make_shared<RoundRobinScheduling>());
+	container.add(std::make_unique<LoggingGenerator>("d", 1, computed));
+	computed.clear();
+	while (container.canCompute())
+		container.compute();
+	EXPECT_EQ(computed, std::vector<std::string>({ "a", "c", "d" }));
+}
+
+TEST(ContainerBase, guidedScheduling) {
+	std::vector<std::string> computed;
+
+	class LoggingForward : public PropagatingForward
+	{
+		std::vector<std::string>& log_;
+
+	public:
+		LoggingForward(const std::string& name, std::vector<std::string>& log) : PropagatingForward(name), log_(log) {}
+		void computeForward(const InterfaceState& from) override {
+			log_.push_back(name());
+			sendForward(from, InterfaceState(from.scene()), SubTrajectory(nullptr, 1.0));
+		}
+	};
+
+	// second propagator's pending states are deeper, but more costly than the first one's
+	auto plan = [&](const SchedulingPolicyPtr& policy) {
+		computed.clear();
+		Task t("scheduling");
+		t.setRobotModel(getModel());
+		auto serial = new SerialContainer("serial");
+		serial->setSchedulingPolicy(policy);
+		// generator spawning two states at once
+		auto generator = std::make_unique<SpawningGeneratorMockup>(std::vector<double>{ 0.0, 0.0 }, 2, "generator");
+		generator->setLog(&computed);
+		serial->add(std::move(generator));
+		serial->add(std::make_unique<LoggingForward>("first", computed));
+		serial->add(std::make_unique<LoggingForward>("second", computed));
+		t.add(Stage::pointer(serial));
+		EXPECT_TRUE(t.plan());
+		EXPECT_EQ(t.numSolutions(), 2u);
+	};
+
+	plan(std::make_shared<CostGuidedScheduling>());
+	EXPECT_EQ(computed, std::vector<std::string>({ "generator", "first", "first", "second", "second" }));
+
+	plan(std::make_shared<CompletionGuidedScheduling>());
+	EXPECT_EQ(computed, std::vector<std::string>({ "generator", "first", "second", "first", "second" }));
+}
+
+TEST(ComputeTimeHistogram, percentile) {
+	ComputeTimeHistogram h;
+	EXPECT_EQ(h.percentile(0.5), 0.0);
+
+	for (int i = 0; i < 99; ++i)
+		h.add(1e-3);
+	h.add(1.0);  // heavy tail
+	EXPECT_EQ(h.count(), 100u);
+	EXPECT_EQ(h.max(), 1.0);
+
+	// percentiles are accurate up to a factor of sqrt(2)
+	EXPECT_GE(h.percentile(0.5), 1e-3);
+	EXPECT_LT(h.percentile(0.5), 1e-3 * std::sqrt(2.0));
+	EXPECT_LT(h.percentile(0.99), 1e-3 * std::sqrt(2.0));
+	EXPECT_EQ(h.percentile(1.0), 1.0);
+}
+
+TEST(Task, trace) {
+	Task t("traced");
+	t.setRobotModel(getModel());
+	auto ref = new stages::FixedState("fixed");
+	ref->setState(std::make_shared<planning_scene::PlanningScene>(t.getRobotModel()));
+	t.add(Stage::pointer(ref));
+
+	trace::Tracer& tracer = trace::Tracer::instance();
+	tracer.enable(1024);
+	EXPECT_TRUE(t.plan());
+	tracer.disable();
+
+	std::ostringstream os;
+	tracer.dump(os);
+	const std::string json = os.str();
+	EXPECT_EQ(json.find("{\"traceEvents\":["), 0u);
+	EXPECT_NE(json.find("\"name\":\"fixed\",\"cat\":\"compute\",\"ph\":\"B\""), std::string::npos);
+	EXPECT_NE(json.find("\"name\":\"fixed\",\"cat\":\"spawn\",\"ph\":\"E\""), std::string::npos);
+}
+
+TEST(Stage, memoryUsage) {
+	Task t("memory");
+	t.setRobotModel(getModel());
+	auto ref = new stages::FixedState("fixed");
+	ref->setState(std::make_shared<planning_scene::PlanningScene>(t.getRobotModel()));
+	t.add(Stage::pointer(ref));
+	EXPECT_EQ(ref->memoryUsage().total(), 0u);
+
+	EXPECT_TRUE(t.plan());
+	MemoryUsage usage = ref->memoryUsage();
+	EXPECT_EQ(usage.states, 2 * (sizeof(InterfaceState) + sizeof(SolutionBase*)));
+	EXPECT_GT(usage.scenes, sizeof(planning_scene::PlanningScene));
+	// the container only copies states, but doesn't own scenes
+	EXPECT_EQ(t.stages()->memoryUsage().scenes, 0u);
+
+	std::ostringstream memory;
+	t.printMemoryUsage(memory);
+	EXPECT_NE(memory.str().find("memory: "), std::string::npos);
+	std::ostringstream state;
+	t.printState(state);
+	EXPECT_EQ(state.str().find("KiB"), std::string::npos) << "memory is reported on request only";
+}
+
+TEST(Task, solutionRetention) {
+	Task t("retention");
+	t.setRobotModel(getModel());
+	// best solution improves over time
+	t.add(std::make_unique<SpawningGeneratorMockup>(std::vector<double>{ 3.0, 4.0, 2.0, 5.0, 1.0 }));
+	t.setSolutionRetention(2);
+	// hold the first best solution (cost 3), which is dropped later on
+	SolutionBaseConstPtr held;
+	t.addTaskCallback([&held](const Task& t) {
+		if (!held)
+			held = t.bestSolution();
+	});
+
+	EXPECT_TRUE(t.plan());
+	ASSERT_EQ(t.numSolutions(), 2u);
+	EXPECT_EQ(t.solutions().front()->cost(), 1.0);
+	EXPECT_EQ(t.solutions().back()->cost(), 2.0);
+
+	// dropped solution is still usable by its holder
+	ASSERT_TRUE(held);
+	EXPECT_EQ(held->cost(), 3.0);
+	ASSERT_TRUE(held->start() && held->end());
+	moveit_task_constructor_msgs::Solution msg;
+	held->fillMessage(msg);
+	EXPECT_EQ(msg.sub_trajectory.size(), 1u);
+}
+
+TEST(PropagatingEitherWay, resultCaching) {
+	class CountingForward : public PropagatingForward
+	{
+	public:
+		size_t runs = 0;
+		CountingForward() : PropagatingForward("counting") {}
+		void computeForward(const InterfaceState& from) override {
+			++runs;
+			sendForward(from, InterfaceState(from.scene()), SubTrajectory(nullptr, 1.0));
+		}
+	};
+
+	Task t("caching");
+	t.setRobotModel(getModel());
+	auto scene = std::make_shared<planning_scene::PlanningScene>(t.getRobotModel());
+	auto ref = new stages::FixedState("fixed");
+	ref->setState(scene);
+	t.add(Stage::pointer(ref));
+	auto counting = new CountingForward();
+	counting->setResultCaching(true);
+	t.add(Stage::pointer(counting));
+
+	EXPECT_TRUE(t.plan());
+	EXPECT_TRUE(t.plan());  // replanning reuses previous result
+	EXPECT_EQ(counting->runs, 1u);
+	EXPECT_EQ(counting->numCacheHits(), 1u);
+	EXPECT_EQ(t.solutions().front()->cost(), 1.0);
+
+	// modified scene needs to be computed again
+	scene->getCurrentStateNonConst().setVariablePosition(0, 0.5);
+	ref->setState(scene);
+	EXPECT_TRUE(t.plan());
+	EXPECT_EQ(counting->runs, 2u);
+
+	// properties without serialization cannot identify the input: never cached
+	struct Opaque
+	{
+		int value;
+	};
+	counting->properties().declare<Opaque>("opaque", Opaque{ 0 });
+	EXPECT_TRUE(t.plan());
+	EXPECT_TRUE(t.plan());
+	EXPECT_EQ(counting->runs, 4u);
+	EXPECT_EQ(counting->numCacheHits(), 1u);
+}
+
+TEST(TaskTemplate, instantiate) {
+	auto robot_model = getModel();
+	auto scene = std::make_shared<planning_scene::PlanningScene>(robot_model);
+
+	size_t built = 0;
+	auto configure = [scene, &built](Task& t) {
+		++built;
+		auto ref = new stages::FixedState("fixed");
+		ref->setState(scene);
+		t.add(Stage::pointer(ref));
+	};
+	TaskTemplate blueprint(configure, robot_model);
+	blueprint.setProperty("group", "group");
+
+	Task first = blueprint.instantiate("first");
+	Task second = blueprint.instantiate("second");
+	EXPECT_EQ(built, 2u) << "stage tree is built per instance";
+	EXPECT_EQ(first.getRobotModel(), second.getRobotModel());
+	EXPECT_EQ(second.properties().get<std::string>("group"), "group");
+
+	// instances are independent
+	EXPECT_TRUE(first.plan());
+	EXPECT_EQ(first.numSolutions(), 1u);
+	EXPECT_EQ(second.numSolutions(), 0u);
+	EXPECT_TRUE(second.plan());
+}
+
+TEST(BatchPlanner, plan) {
+	auto robot_model = getModel();
+
+	std::vector<Task> tasks;
+	tasks.reserve(3);
+	for (const char* id : { "first", "second", "third" }) {
+		tasks.emplace_back(id);
+		tasks.back().setRobotModel(robot_model);
+		auto ref = new stages::FixedState("fixed");
+		ref->setState(std::make_shared<planning_scene::PlanningScene>(robot_model));
+		tasks.back().add(Stage::pointer(ref));
+	}
+
+	std::atomic<size_t> num_done{ 0 };
+	BatchPlanner planner(2);
+	std::vector<std::future<bool>> results;
+	for (Task& t : tasks)
+		results.push_back(planner.add(t, 1, 0.0, 1.0, [&num_done](Task& /* task */, bool success) {
+			if (success)
+				++num_done;
+		}));
+	planner.wait();
+
+	EXPECT_EQ(planner.numPending(), 0u);
+	EXPECT_EQ(num_done, tasks.size());
+	for (auto& result : results)
+		EXPECT_TRUE(result.get());
+	for (const Task& t : tasks)
+		EXPECT_EQ(t.numSolutions(), 1u);
+}
+
+TEST(Cancellation, scope) {
+	EXPECT_FALSE(cancellation::requested());
+	std::atomic<bool> outer{ false };
+	std::atomic<bool> inner{ true };
+	{
+		cancellation::Scope outer_scope(&outer);
+		EXPECT_FALSE(cancellation::requested());
+		{
+			cancellation::Scope inner_scope(&inner);
+			EXPECT_TRUE(cancellation::requested());
+		}
+		EXPECT_EQ(cancellation::current(), &outer);
+		outer = true;
+		EXPECT_TRUE(cancellation::requested());
+		// other threads are not affected
+		EXPECT_FALSE(std::async(std::launch::async, [] { return cancellation::requested(); }).get());
+	}
+	EXPECT_EQ(cancellation::current(), nullptr);
+}
+
+TEST(Fallbacks, speculative) {
+	Task t("speculative");
+	t.setRobotModel(getModel());
+	auto fallbacks = std::make_unique<Fallbacks>();
+	fallbacks->setSpeculative(true);
+	fallbacks->add(std::make_unique<GeneratorMockup>(3));  // primary, never succeeding
+	fallbacks->add(std::make_unique<SpawningGeneratorMockup>(std::vector<double>{ 0.0, 0.0 }));
+	t.add(std::move(fallbacks));
+
+	std::vector<size_t> num_solutions;
+	t.addTaskCallback([&num_solutions](const Task& t) { num_solutions.push_back(t.numSolutions()); });
+	EXPECT_TRUE(t.plan());
+	// solutions of the fallback are held back until the primary child is exhausted
+	ASSERT_GE(num_solutions.size(), 3u);
+	EXPECT_EQ(num_solutions[0], 0u);
+	EXPECT_EQ(num_solutions[1], 0u);
+	EXPECT_EQ(t.numSolutions(), 2u);
+}
+
+// generator spawning some states after waiting (bounded) for another instance to compute concurrently
+class RendezvousGenerator : public Generator
+{
+	std::atomic<int>& arrived_;
+	bool done_ = false;
+	planning_scene::PlanningScenePtr scene_;
+
+public:
+	bool overlapped = false;
+
+	RendezvousGenerator(std::atomic<int>& arrived) : Generator("rendezvous"), arrived_(arrived) {}
+	void init(const moveit::core::RobotModelConstPtr& robot_model) override {
+		Generator::init(robot_model);
+		scene_ = std::make_shared<planning_scene::PlanningScene>(robot_model);
+	}
+	bool canCompute() const override { return !done_; }
+	void compute() override {
+		done_ = true;
+		++arrived_;
+		auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(2);
+		while (arrived_ < 2 && std::chrono::steady_clock::now() < deadline)
+			std::this_thread::sleep_for(std::chrono::milliseconds(1));
+		overlapped = arrived_ >= 2;
+		for (int i = 0; i < 50; ++i)
+			spawn(InterfaceState(scene_), static_cast<double>(i));
+	}
+};
+
+TEST(Fallbacks, speculativeConcurrentStates) {
+	Task t("speculative");
+	t.setRobotModel(getModel());
+	std::atomic<int> arrived{ 0 };
+	auto fallbacks = std::make_unique<Fallbacks>();
+	fallbacks->setSpeculative(true);
+	auto primary = new RendezvousGenerator(arrived);
+	auto fallback = new RendezvousGenerator(arrived);
+	fallbacks->add(Stage::pointer(primary));
+	fallbacks->add(Stage::pointer(fallback));
+	auto fallbacks_impl = fallbacks->pimpl();
+	t.add(std::move(fallbacks));
+
+	EXPECT_TRUE(t.plan());
+	EXPECT_TRUE(primary->overlapped && fallback->overlapped) << "children didn't run concurrently";
+	// all states pushed concurrently arrived in the container's interfaces
+	EXPECT_EQ(fallbacks_impl->pendingForward()->size(), 100u);
+	EXPECT_EQ(fallbacks_impl->pendingBackward()->size(), 100u);
+	EXPECT_EQ(t.numSolutions(), 100u);
+}
+
+TEST(Alternatives, concurrent) {
+	Task t("concurrent");
+	t.setRobotModel(getModel());
+	auto alternatives = std::make_unique<Alternatives>();
+	alternatives->setConcurrent(true);
+	for (double cost : { 3.0, 1.0, 2.0 })
+		alternatives->add(std::make_unique<SpawningGeneratorMockup>(std::vector<double>{ cost }, 1,
+		                                                            "cost " + std::to_string(cost)));
+	t.add(std::move(alternatives));
+
+	std::vector<double> reported;
+	t.addSolutionCallback([&reported](const SolutionBase& s) { reported.push_back(s.cost()); });
+	EXPECT_TRUE(t.plan());
+	EXPECT_EQ(t.numSolutions(), 3u);
+	// all children computed in a single iteration, solutions are lifted in cost order
+	EXPECT_EQ(reported, std::vector<double>({ 1.0, 2.0, 3.0 }));
+}
+
+TEST(Alternatives, concurrentStates) {
+	Task t("concurrent");
+	t.setRobotModel(getModel());
+	std::atomic<int> arrived{ 0 };
+	auto alternatives = std::make_unique<Alternatives>();
+	alternatives->setConcurrent(true);
+	auto first = new RendezvousGenerator(arrived);
+	auto second = new RendezvousGenerator(arrived);
+	alternatives->add(Stage::pointer(first));
+	alternatives->add(Stage::pointer(second));
+	auto alternatives_impl = alternatives->pimpl();
+	t.add(std::move(alternatives));
+
+	EXPECT_TRUE(t.plan());
+	EXPECT_TRUE(first->overlapped && second->overlapped) << "children didn't run concurrently";
+	EXPECT_EQ(alternatives_impl->pendingForward()->size(), 100u);
+	EXPECT_EQ(alternatives_impl->pendingBackward()->size(), 100u);
+	EXPECT_EQ(t.numSolutions(), 100u);
+}
+
+TEST(Merger, bestCombinations) {
+	GeneratorMockup a, b, c;
+	auto make = [](StagePrivate* creator, double cost) {
+		auto s = std::make_shared<SubTrajectory>(nullptr, cost);
+		s->setCreator(creator);
+		return s;
+	};
+	std::vector<SubTrajectoryPtr> storage = { make(a.pimpl(), 0.0), make(b.pimpl(), 2.0), make(b.pimpl(), 1.0),
+		                                       make(c.pimpl(), 0.5), make(c.pimpl(), 3.0) };
+	MergerPrivate::ChildSolutionMap all;
+	for (const auto& s : storage)
+		all[s->creator()].push_back(s.get());
+
+	// combinations with the new solution of a, sorted by summed cost
+	auto combinations = MergerPrivate::bestCombinations(all, *storage[0], 0);
+	ASSERT_EQ(combinations.size(), 4u);
+	std::vector<double> costs;
+	for (const auto& combination : combinations) {
+		double sum = 0.0;
+		for (const SubTrajectory* s : combination)
+			sum += s->cost();
+		costs.push_back(sum);
+	}
+	EXPECT_EQ(costs, std::vector<double>({ 1.5, 2.5, 4.0, 5.0 }));
+
+	// limit number of combinations
+	EXPECT_EQ(MergerPrivate::bestCombinations(all, *storage[0], 2).size(), 2u);
+}
+
+TEST(Connecting, groupPairs) {
+	class GroupingConnect : public Connecting
+	{
+	public:
+		std::vector<size_t> group_sizes;
+		bool fail_groups = false;
+		void compute(const InterfaceState& /*from*/, const InterfaceState& /*to*/) override { group_sizes.push_back(1); }
+		StatePairList computeGroup(const StatePairList& pairs) override {
+			for (const auto& pair : pairs)
+				EXPECT_EQ(pair.first, pairs.front().first) << "pairs should share start state";
+			group_sizes.push_back(pairs.size());
+			return fail_groups ? pairs : StatePairList();
+		}
+	};
+
+	for (bool fail_groups : { false, true }) {
+		Task t("grouping");
+		t.setRobotModel(getModel());
+		auto connect = new GroupingConnect();
+		connect->fail_groups = fail_groups;
+		connect->setMaxGroupSize(2);
+		t.add(std::make_unique<SpawningGeneratorMockup>(std::vector<double>{ 0.0 }));
+		t.add(Stage::pointer(connect));
+		// three end states spawned at once
+		t.add(std::make_unique<SpawningGeneratorMockup>(std::vector<double>{ 0.0, 1.0, 2.0 }, 3));
+		t.plan();
+
+		if (!fail_groups)  // three pairs sharing the start state, grouped by at most two
+			EXPECT_EQ(connect->group_sizes, std::vector<size_t>({ 2, 1 }));
+		else  // pairs of a failed group are computed individually
+			EXPECT_EQ(connect->group_sizes, std::vector<size_t>({ 2, 1, 1, 1 }));
+	}
+}
@@ -1,5 +1,10 @@
+#include <atomic>
 #include <list>
+#include <thread>
 #include <moveit/task_constructor/storage.h>
+#include <moveit/planning_scene/planning_scene.h>
+#include <moveit/robot_trajectory/robot_trajectory.h>
+#include <moveit/utils/robot_model_test_utils.h>
 #include <gtest/gtest.h>
 
 using namespace moveit::task_constructor;
@@ -17,3 +22,206 @@ TEST(InterfaceStatePriority, compare) {
 	EXPECT_TRUE(Prio(0, 0) < Prio(0, inf));
 	EXPECT_TRUE(Prio(0, inf) > Prio(0, 0));
 }
+
+TEST(InterfaceState, flattenSceneDiffChain) {
+	moveit::core::RobotModelBuilder builder("robot", "base");
+	builder.addChain("base->a->b->c", "continuous");
+	auto scene = std::make_shared<planning_scene::PlanningScene>(builder.build());
+
+	InterfaceState::SceneFlattening policy;
+	policy.max_depth = 3;
+	size_t flattened = InterfaceState::numFlattenedScenes();
+
+	planning_scene::PlanningScenePtr diff = scene;
+	for (int i = 0; i < 3; ++i)
+		diff = diff->diff();
+	InterfaceState shallow(diff);
+	shallow.flattenScene(policy);
+	EXPECT_EQ(shallow.scene(), diff);
+	EXPECT_EQ(InterfaceState::numFlattenedScenes(), flattened);
+
+	diff = diff->diff();
+	InterfaceState deep(diff);
+	deep.flattenScene(policy);
+	EXPECT_NE(deep.scene(), diff);  // scenes might be shared: they are replaced, not modified
+	EXPECT_FALSE(deep.scene()->getParent());
+	EXPECT_TRUE(diff->getParent());
+	EXPECT_EQ(InterfaceState::numFlattenedScenes(), flattened + 1);
+
+	// lazy states are flattened on creation
+	InterfaceState lazy(diff, nullptr, {});
+	lazy.flattenScene(policy);
+	EXPECT_FALSE(lazy.sceneMaterialized());
+	EXPECT_FALSE(lazy.scene()->getParent());
+
+	InterfaceState disabled(diff->diff());
+	disabled.flattenScene(InterfaceState::SceneFlattening());
+	EXPECT_TRUE(disabled.scene()->getParent());
+}
+
+TEST(InterfaceState, flattenByLookupCost) {
+	moveit::core::RobotModelBuilder builder("robot", "base");
+	builder.addChain("base->a->b->c", "continuous");
+	auto scene = std::make_shared<planning_scene::PlanningScene>(builder.build());
+
+	InterfaceState::SceneFlattening policy;
+	policy.max_lookup_cost = 6;
+
+	// overriding the robot state in each diff keeps state lookups cheap
+	planning_scene::PlanningScenePtr diff = scene;
+	for (int i = 0; i < 3; ++i) {
+		diff = diff->diff();
+		diff->getCurrentStateNonConst().setToDefaultValues();
+	}
+	InterfaceState cheap(diff);  // ACM and transforms lookups traverse 3 parents each
+	cheap.flattenScene(policy);
+	EXPECT_TRUE(cheap.scene()->getParent());
+
+	// but ACM and transforms lookups still traverse the whole chain
+	diff = diff->diff();
+	diff->getCurrentStateNonConst().setToDefaultValues();
+	InterfaceState expensive(diff);
+	expensive.flattenScene(policy);
+	EXPECT_FALSE(expensive.scene()->getParent());
+}
+
+TEST(InterfaceState, sceneInterning) {
+	moveit::core::RobotModelBuilder builder("robot", "base");
+	builder.addChain("base->a->b->c", "continuous");
+	auto scene = std::make_shared<planning_scene::PlanningScene>(builder.build());
+	InterfaceState::setSceneInterning(true);
+	size_t interned = InterfaceState::numInternedScenes();
+
+	// scenes only differing in robot state share a base scene
+	auto first = scene->diff();
+	first->getCurrentStateNonConst().setToRandomPositions();
+	auto second = scene->diff()->diff();
+	second->getCurrentStateNonConst().setToRandomPositions();
+	InterfaceState s1(first), s2(second);
+	EXPECT_EQ(InterfaceState::numInternedScenes(), interned + 1);
+	ASSERT_TRUE(s1.scene()->getParent());
+	EXPECT_EQ(s1.scene()->getParent(), s2.scene()->getParent());
+	EXPECT_EQ(s1.scene()->getCurrentState().getVariablePosition(0),
+	          first->getCurrentState().getVariablePosition(0));
+
+	// different ACM results in a different base
+	auto third = scene->diff();
+	third->getAllowedCollisionMatrixNonConst().setEntry("a", "c", true);
+	InterfaceState s3(third);
+	EXPECT_NE(s1.scene()->getParent(), s3.scene()->getParent());
+	EXPECT_EQ(InterfaceState::numInternedScenes(), interned + 1);
+
+	InterfaceState::setSceneInterning(false);
+}
+
+TEST(InterfaceState, lazyScene) {
+	moveit::core::RobotModelBuilder builder("robot", "base");
+	builder.addChain("base->a->b->c", "continuous");
+	builder.addGroupChain("base", "c", "group");
+	auto scene = std::make_shared<planning_scene::PlanningScene>(builder.build());
+	const moveit::core::JointModelGroup* jmg = scene->getRobotModel()->getJointModelGroup("group");
+
+	size_t num_deltas = 0;
+	InterfaceState state(scene, jmg, { 0.1, 0.2, 0.3 }, [&num_deltas](planning_scene::PlanningScene&) { ++num_deltas; });
+	InterfaceState copy(state);
+	EXPECT_TRUE(state.hasScene());
+	EXPECT_FALSE(state.sceneMaterialized());
+
+	const planning_scene::PlanningSceneConstPtr& created = state.scene();
+	EXPECT_TRUE(state.sceneMaterialized());
+	EXPECT_EQ(created->getParent(), scene);
+	EXPECT_FALSE(created->getCurrentState().dirty());
+	std::vector<double> values;
+	created->getCurrentState().copyJointGroupPositions(jmg, values);
+	EXPECT_EQ(values, std::vector<double>({ 0.1, 0.2, 0.3 }));
+
+	// copies share the created scene
+	EXPECT_EQ(copy.scene(), created);
+	EXPECT_EQ(num_deltas, 1u);
+}
+
+TEST(InterfaceState, lazySceneConcurrentAccess) {
+	moveit::core::RobotModelBuilder builder("robot", "base");
+	builder.addChain("base->a->b->c", "continuous");
+	auto scene = std::make_shared<planning_scene::PlanningScene>(builder.build());
+
+	std::atomic<size_t> num_deltas{ 0 };
+	const InterfaceState state(scene, nullptr, {}, [&num_deltas](planning_scene::PlanningScene&) { ++num_deltas; });
+	std::vector<planning_scene::PlanningSceneConstPtr> scenes(4);
+	std::vector<std::thread> threads;
+	for (auto& s : scenes)
+		threads.emplace_back([&state, &s]() { s = state.scene(); });
+	for (auto& thread : threads)
+		thread.join();
+
+	EXPECT_EQ(num_deltas, 1u);
+	for (const auto& s : scenes)
+		EXPECT_EQ(s, scenes.front());
+	EXPECT_TRUE(state.sceneMaterialized());
+}
+
+TEST(SubTrajectory, deferredTiming) {
+	moveit::core::RobotModelBuilder builder("robot", "base");
+	builder.addChain("base->a->b", "continuous");
+	builder.addGroupChain("base", "b", "group");
+	moveit::core::RobotModelConstPtr robot_model = builder.build();
+	const moveit::core::JointModelGroup* jmg = robot_model->getJointModelGroup("group");
+
+	moveit::core::RobotState state(robot_model);
+	state.setToDefaultValues();
+	auto trajectory = std::make_shared<robot_trajectory::RobotTrajectory>(robot_model, jmg);
+	trajectory->addSuffixWayPoint(state, 0.0);
+	state.setJointGroupPositions(jmg, { 0.1, 0.2 });
+	trajectory->addSuffixWayPoint(state, 0.0);
+
+	size_t num_timings = 0;
+	SubTrajectory solution;
+	solution.setTrajectory(trajectory, [&num_timings](robot_trajectory::RobotTrajectory& t) {
+		++num_timings;
+		t.setWayPointDurationFromPrevious(1, 0.5);
+	});
+	SubTrajectory copy(solution);
+	EXPECT_EQ(num_timings, 0u);
+	EXPECT_DOUBLE_EQ(solution.trajectory()->getDuration(), 0.0);
+
+	// timing is computed on first use, once for all copies
+	EXPECT_DOUBLE_EQ(copy.timedTrajectory()->getDuration(), 0.5);
+	EXPECT_DOUBLE_EQ(solution.timedTrajectory()->getDuration(), 0.5);
+	EXPECT_EQ(num_timings, 1u);
+	// the untimed trajectory is left untouched, as it might be read concurrently
+	EXPECT_DOUBLE_EQ(solution.trajectory()->getDuration(), 0.0);
+}
+
+TEST(Interface, prune) {
+	moveit::core::RobotModelBuilder builder("robot", "base");
+	builder.addChain("base->a->b->c", "continuous");
+	auto scene = std::make_shared<planning_scene::PlanningScene>(builder.build());
+
+	std::list<InterfaceState> states;
+	std::list<SubTrajectory> solutions;
+	Interface interface;
+	auto add = [&](double cost) {
+		states.emplace_back(scene);
+		solutions.emplace_back(robot_trajectory::RobotTrajectoryConstPtr(), cost);
+		solutions.back().setEndState(states.back());
+		interface.add(states.back());
+		return &states.back();
+	};
+
+	add(1.0);
+	InterfaceState* expensive = add(3.0);
+	auto pruned = interface.prune(2.0);
+	ASSERT_EQ(pruned.size(), 1u);
+	EXPECT_EQ(pruned.front(), expensive);
+	EXPECT_FALSE(expensive->owner());
+	EXPECT_EQ(interface.size(), 1u);
+
+	// states arriving later are checked against the bound too
+	EXPECT_FALSE(add(2.5)->owner());
+	EXPECT_EQ(add(1.5)->owner(), &interface);
+	EXPECT_EQ(interface.size(), 2u);
+
+	// clearing lifts the bound
+	interface.clear();
+	EXPECT_EQ(add(2.5)->owner(), &interface);
+}
@@ -0,0 +1,128 @@
+#include <moveit/task_constructor/task.h>
+#include <moveit/task_constructor/introspection.h>
+#include <moveit/planning_scene/planning_scene.h>
+#include <moveit/utils/robot_model_test_utils.h>
+
+#include <ros/init.h>
+#include <gtest/gtest.h>
+#include <map>
+#include <set>
+
+using namespace moveit::task_constructor;
+
+// generator spawning a single failure per compute(), commented with its sequence number
+class FailingGenerator : public Generator
+{
+	planning_scene::PlanningScenePtr scene_;
+	size_t count_ = 0;
+
+public:
+	size_t runs = 0;
+
+	FailingGenerator() : Generator("failing generator") {}
+	void init(const moveit::core::RobotModelConstPtr& robot_model) override {
+		Generator::init(robot_model);
+		scene_ = std::make_shared<planning_scene::PlanningScene>(robot_model);
+	}
+	bool canCompute() const override { return count_ < runs; }
+	void compute() override {
+		SubTrajectory failure;
+		failure.markAsFailure();
+		failure.setComment(std::to_string(count_++));
+		spawn(InterfaceState(scene_), std::move(failure));
+	}
+};
+
+class FailureRetention : public ::testing::Test
+{
+protected:
+	Task task{ "failures" };
+	FailingGenerator* generator;
+
+	void SetUp() override {
+		moveit::core::RobotModelBuilder builder("robot", "base");
+		builder.addChain("base->a->b", "continuous");
+		task.setRobotModel(builder.build());
+		auto g = std::make_unique<FailingGenerator>();
+		generator = g.get();
+		task.add(std::move(g));
+	}
+
+	std::vector<std::string> comments() const {
+		std::vector<std::string> result;
+		for (const auto& failure : generator->failures())
+			result.push_back(failure->comment());
+		return result;
+	}
+};
+
+TEST_F(FailureRetention, keepAll) {
+	generator->runs = 10;
+	task.plan();
+	ASSERT_TRUE(generator->storeFailures());  // requires introspection
+	EXPECT_EQ(generator->numFailures(), 10u);
+	EXPECT_EQ(generator->failures().size(), 10u);
+}
+
+TEST_F(FailureRetention, keepLast) {
+	generator->runs = 10;
+	generator->setFailureRetention(Stage::KEEP_LAST, 3);
+	task.plan();
+	EXPECT_EQ(generator->numFailures(), 10u);
+	EXPECT_EQ(comments(), std::vector<std::string>({ "7", "8", "9" }));
+	// states spawned for evicted failures are released: two states per retained failure remain
+	EXPECT_EQ(generator->memoryUsage().states, 3 * 2 * (sizeof(InterfaceState) + sizeof(SolutionBase*)));
+}
+
+TEST_F(FailureRetention, keepLastCountOnly) {
+	generator->runs = 10;
+	generator->setFailureRetention(Stage::KEEP_LAST, 0);
+	task.plan();
+	EXPECT_EQ(generator->numFailures(), 10u);
+	EXPECT_TRUE(generator->failures().empty());
+}
+
+TEST_F(FailureRetention, reservoir) {
+	generator->runs = 100;
+	generator->setFailureRetention(Stage::RESERVOIR, 5);
+	task.plan();
+	EXPECT_EQ(generator->numFailures(), 100u);
+	auto retained = comments();
+	EXPECT_EQ(retained.size(), 5u);
+	EXPECT_EQ(std::set<std::string>(retained.begin(), retained.end()).size(), 5u);
+	// not simply the first or last ones
+	EXPECT_NE(retained, std::vector<std::string>({ "0", "1", "2", "3", "4" }));
+}
+
+TEST_F(FailureRetention, introspectionIds) {
+	generator->runs = 10;
+	generator->setFailureRetention(Stage::KEEP_LAST, 2);
+
+	// record ids of all failures, as seen after each planning step
+	std::map<std::string, uint32_t> ids;
+	task.addTaskCallback([this, &ids](const Task& /*task*/) {
+		for (const auto& failure : generator->failures()) {
+			uint32_t id = task.introspection().solutionId(*failure);
+			auto inserted = ids.insert(std::make_pair(failure->comment(), id));
+			EXPECT_EQ(inserted.first->second, id) << "id of failure " << failure->comment() << " changed";
+		}
+	});
+	task.plan();
+	ASSERT_EQ(ids.size(), 10u);
+
+	// ids of retained failures remain valid after evicting others
+	for (const auto& failure : generator->failures())
+		EXPECT_EQ(task.introspection().solutionId(*failure), ids[failure->comment()]);
+
+	// ids of evicted failures are not reused
+	std::set<uint32_t> unique;
+	for (const auto& pair : ids)
+		unique.insert(pair.second);
+	EXPECT_EQ(unique.size(), ids.size());
+}
+
+int main(int argc, char** argv) {
+	testing::InitGoogleTest(&argc, argv);
+	ros::init(argc, argv, "test_introspection");
+	return RUN_ALL_TESTS();
+}
@@ -1,13 +1,32 @@
 #include "models.h"
+#include "stage_mockups.h"
 
 #include <moveit/task_constructor/stage_p.h>
 #include <moveit/task_constructor/stages/compute_ik.h>
 #include <moveit/task_constructor/stages/modify_planning_scene.h>
+#include <moveit/task_constructor/stages/connect.h>
+#include <moveit/task_constructor/stages/fixed_state.h>
+#include <moveit/task_constructor/solvers/joint_interpolation.h>
+#include <moveit/task_constructor/solvers/pipeline_planner.h>
+#include <moveit/task_constructor/task.h>
+#include <moveit/task_constructor/solvers/experience_database.h>
+#include <moveit/task_constructor/solvers/roadmap_planner.h>
+#include <moveit/task_constructor/reachability_map.h>
+#include <moveit/planning_interface/planning_response.h>
 #include <moveit/planning_scene/planning_scene.h>
+#include <moveit/robot_trajectory/robot_trajectory.h>
+#include <moveit/utils/robot_model_test_utils.h>
 #include <geometry_msgs/PoseStamped.h>
+#include <geometric_shapes/shapes.h>
+#include <shape_msgs/SolidPrimitive.h>
 
 #include <ros/console.h>
 #include <gtest/gtest.h>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <thread>
+#include <unistd.h>
 
 using namespace moveit::task_constructor;
 using namespace planning_scene;
@@ -38,6 +57,34 @@ public:
 	}
 };
 
+// pipeline planner without a planning pipeline: directly moves to the last goal of each request
+class PipelineMockup : public solvers::PipelinePlanner
+{
+public:
+	std::vector<size_t> num_goals;  // number of goal constraints per request
+	bool fail_multi_goal = false;  // fail requests comprising multiple goals
+
+	void init(const moveit::core::RobotModelConstPtr& /*robot_model*/) override {}
+
+protected:
+	bool generatePlan(const PlanningSceneConstPtr& from, const moveit_msgs::MotionPlanRequest& req,
+	                  planning_interface::MotionPlanResponse& res) override {
+		num_goals.push_back(req.goal_constraints.size());
+		if (fail_multi_goal && req.goal_constraints.size() > 1)
+			return false;
+		moveit::core::RobotState goal(from->getCurrentState());
+		for (const auto& constraint : req.goal_constraints.back().joint_constraints)
+			goal.setVariablePosition(constraint.joint_name, constraint.position);
+		goal.update();
+		const moveit::core::JointModelGroup* jmg = from->getRobotModel()->getJointModelGroup(req.group_name);
+		res.trajectory_ = std::make_shared<robot_trajectory::RobotTrajectory>(from->getRobotModel(), jmg);
+		res.trajectory_->addSuffixWayPoint(from->getCurrentState(), 0.0);
+		res.trajectory_->addSuffixWayPoint(goal, 0.1);
+		res.error_code_.val = moveit_msgs::MoveItErrorCodes::SUCCESS;
+		return true;
+	}
+};
+
 class ConnectMockup : public Connecting
 {
 public:
@@ -45,6 +92,17 @@ public:
 	void compute(const InterfaceState& from, const InterfaceState& to) override {}
 };
 
+// create a unique, empty file in $TMPDIR (or /tmp) and return its name
+std::string tempFile(const std::string& prefix) {
+	const char* dir = std::getenv("TMPDIR");
+	std::string name = std::string(dir && *dir ? dir : "/tmp") + "/" + prefix + "XXXXXX";
+	int fd = mkstemp(&name[0]);
+	if (fd < 0)
+		return std::string();
+	close(fd);
+	return name;
+}
+
 TEST(Stage, registerCallbacks) {
 	ros::console::set_logger_level(ROSCONSOLE_ROOT_LOGGER_NAME, ros::console::levels::Fatal);
 
@@ -108,6 +166,63 @@ TEST(ModifyPlanningScene, allowCollisions) {
 	s->allowCollisions("foo", std::set<const char*>{ "ab", "abc" }, false);
 }
 
+// scene diffs published with a ModifyPlanningScene solution, planned from a start scene
+static moveit_msgs::PlanningScene modifiedSceneDiff(Task& t, const InterfaceState::SceneFlattening& flattening = {}) {
+	moveit::core::RobotModelBuilder builder("robot", "base");
+	builder.addChain("base->a->b", "continuous");
+	t.setRobotModel(builder.build());
+
+	auto fixed = new stages::FixedState("start");
+	fixed->setState(std::make_shared<PlanningScene>(t.getRobotModel())->diff());
+	t.add(Stage::pointer(fixed));
+
+	moveit_msgs::CollisionObject object;
+	object.id = "box";
+	object.header.frame_id = "base";
+	object.primitive_poses.resize(1);
+	object.primitive_poses[0].orientation.w = 1.0;
+	object.primitives.resize(1);
+	object.primitives[0].type = shape_msgs::SolidPrimitive::BOX;
+	object.primitives[0].dimensions = { 0.1, 0.1, 0.1 };
+	object.operation = moveit_msgs::CollisionObject::ADD;
+	auto modify = new stages::ModifyPlanningScene("modify");
+	modify->addObject(object);
+	modify->allowCollisions("box", true);
+	modify->setSceneFlattening(flattening);
+	t.add(Stage::pointer(modify));
+
+	moveit_task_constructor_msgs::Solution msg;
+	if (!t.plan() || modify->solutions().size() != 1)
+		return moveit_msgs::PlanningScene();
+	modify->solutions().front()->fillMessage(msg);
+	return msg.sub_trajectory.empty() ? moveit_msgs::PlanningScene() : msg.sub_trajectory.front().scene_diff;
+}
+
+TEST(ModifyPlanningScene, sceneDiffWithInterning) {
+	InterfaceState::setSceneInterning(true);
+	Task t("interning");
+	moveit_msgs::PlanningScene diff = modifiedSceneDiff(t);
+	InterfaceState::setSceneInterning(false);
+
+	ASSERT_EQ(diff.world.collision_objects.size(), 1u) << "world changes lost";
+	EXPECT_EQ(diff.world.collision_objects.front().id, "box");
+	EXPECT_FALSE(diff.allowed_collision_matrix.entry_names.empty()) << "ACM changes lost";
+	EXPECT_GT(InterfaceState::numInternedScenes(), 0u);
+}
+
+TEST(ModifyPlanningScene, sceneDiffWithFlattening) {
+	InterfaceState::SceneFlattening flattening;
+	flattening.max_depth = 1;  // start scene is a diff already
+	size_t flattened = InterfaceState::numFlattenedScenes();
+	Task t("flattening");
+	moveit_msgs::PlanningScene diff = modifiedSceneDiff(t, flattening);
+
+	EXPECT_GT(InterfaceState::numFlattenedScenes(), flattened);
+	ASSERT_EQ(diff.world.collision_objects.size(), 1u) << "world changes lost";
+	EXPECT_EQ(diff.world.collision_objects.front().id, "box");
+	EXPECT_FALSE(diff.allowed_collision_matrix.entry_names.empty()) << "ACM changes lost";
+}
+
 void spawnObject(PlanningScene& scene, const std::string& name, int type,
                  const std::vector<double>& pos = { 0, 0, 0 }) {
 	moveit_msgs::CollisionObject o;
@@ -177,3 +292,307 @@ TEST(Connect, compatible) {
 	attachObject(*other, "object", "base_link", true);
 	EXPECT_FALSE(connect.compatible(scene, other)) << "different pose";
 }
+
+TEST(ExperienceDatabase, retrieve) {
+	moveit::core::RobotModelBuilder builder("robot", "base");
+	builder.addChain("base->a->b", "continuous");
+	builder.addGroupChain("base", "b", "group");
+	moveit::core::RobotModelConstPtr robot_model = builder.build();
+	const moveit::core::JointModelGroup* jmg = robot_model->getJointModelGroup("group");
+
+	auto scene_at = [&](double position) {
+		auto scene = std::make_shared<PlanningScene>(robot_model);
+		moveit::core::RobotState& state = scene->getCurrentStateNonConst();
+		state.setJointGroupPositions(jmg, std::vector<double>(jmg->getVariableCount(), position));
+		state.update();
+		return scene;
+	};
+	size_t num_repairs = 0;
+	auto repair = [&num_repairs](const PlanningSceneConstPtr& /*from*/, const PlanningSceneConstPtr& /*to*/,
+	                             robot_trajectory::RobotTrajectoryPtr& /*result*/) {
+		++num_repairs;
+		return false;
+	};
+
+	// store path from 0.0 to 0.5 via 1.0
+	robot_trajectory::RobotTrajectory trajectory(robot_model, jmg);
+	for (double position : { 0.01, 1.0, 0.51 })
+		trajectory.addSuffixWayPoint(scene_at(position)->getCurrentState(), 0.0);
+	solvers::ExperienceDatabase db(0.1);
+	db.add(trajectory);
+
+	robot_trajectory::RobotTrajectoryPtr result;
+	EXPECT_FALSE(db.retrieve(scene_at(0.3), scene_at(0.5), jmg, {}, repair, result)) << "different start cell";
+	ASSERT_TRUE(db.retrieve(scene_at(0.02), scene_at(0.55), jmg, {}, repair, result));
+	EXPECT_EQ(result->getWayPointCount(), 3u);
+	EXPECT_DOUBLE_EQ(result->getFirstWayPoint().getVariablePosition(0), 0.02);
+	EXPECT_DOUBLE_EQ(result->getWayPoint(1).getVariablePosition(0), 1.0);
+	EXPECT_DOUBLE_EQ(result->getLastWayPoint().getVariablePosition(0), 0.55);
+	EXPECT_EQ(num_repairs, 0u);
+	EXPECT_EQ(db.numHits(), 1u);
+
+	// start and goal in cells neighboring the stored ones
+	ASSERT_TRUE(db.retrieve(scene_at(0.12), scene_at(0.62), jmg, {}, repair, result)) << "neighboring cells";
+	EXPECT_EQ(result->getWayPointCount(), 3u);
+	EXPECT_DOUBLE_EQ(result->getFirstWayPoint().getVariablePosition(0), 0.12);
+	EXPECT_DOUBLE_EQ(result->getLastWayPoint().getVariablePosition(0), 0.62);
+	EXPECT_EQ(db.numHits(), 2u);
+
+	// persist and reload
+	const std::string filename = tempFile("mtc_experience_");
+	ASSERT_FALSE(filename.empty());
+	ASSERT_TRUE(db.save(filename));
+	solvers::ExperienceDatabase loaded(0.1);
+	ASSERT_TRUE(loaded.load(filename));
+	std::remove(filename.c_str());
+	EXPECT_EQ(loaded.size(), 1u);
+	EXPECT_TRUE(loaded.retrieve(scene_at(0.0), scene_at(0.5), jmg, {}, repair, result));
+}
+
+TEST(ExperienceDatabase, pipelinePlanner) {
+	moveit::core::RobotModelBuilder builder("robot", "base");
+	builder.addChain("base->a->b", "continuous");
+	builder.addGroupChain("base", "b", "group");
+	moveit::core::RobotModelConstPtr robot_model = builder.build();
+	const moveit::core::JointModelGroup* jmg = robot_model->getJointModelGroup("group");
+
+	auto scene_at = [&](double position) {
+		auto scene = std::make_shared<PlanningScene>(robot_model);
+		moveit::core::RobotState& state = scene->getCurrentStateNonConst();
+		state.setJointGroupPositions(jmg, std::vector<double>(jmg->getVariableCount(), position));
+		state.update();
+		return scene;
+	};
+
+	PipelineMockup planner;
+	auto db = std::make_shared<solvers::ExperienceDatabase>(0.1);
+	planner.setExperienceDatabase(db);
+
+	// miss: plan and store the result
+	robot_trajectory::RobotTrajectoryPtr result;
+	ASSERT_TRUE(planner.plan(scene_at(0.0), scene_at(0.5), jmg, 1.0, result));
+	EXPECT_EQ(planner.num_goals.size(), 1u);
+	EXPECT_EQ(db->size(), 1u);
+	EXPECT_EQ(db->numHits(), 0u);
+
+	// hit: the pipeline isn't queried again
+	ASSERT_TRUE(planner.plan(scene_at(0.01), scene_at(0.51), jmg, 1.0, result));
+	EXPECT_EQ(planner.num_goals.size(), 1u);
+	EXPECT_EQ(db->numHits(), 1u);
+	ASSERT_TRUE(result);
+	EXPECT_DOUBLE_EQ(result->getLastWayPoint().getVariablePosition(0), 0.51);
+
+	// no time left: neither retrieved nor planned
+	ASSERT_FALSE(planner.plan(scene_at(2.0), scene_at(2.5), jmg, 0.0, result));
+	EXPECT_EQ(planner.num_goals.size(), 1u);
+}
+
+TEST(RoadmapPlanner, plan) {
+	// single revolute joint moving an arm of length 1 in the xy plane
+	moveit::core::RobotModelBuilder builder("robot", "base");
+	geometry_msgs::Pose origin, arm;
+	origin.orientation.w = arm.orientation.w = 1.0;
+	arm.position.x = 0.5;
+	builder.addChain("base->a", "continuous", { origin }, urdf::Vector3(0, 0, 1));
+	builder.addCollisionBox("a", { 1.0, 0.1, 0.1 }, arm);
+	builder.addGroupChain("base", "a", "group");
+	moveit::core::RobotModelConstPtr robot_model = builder.build();
+	const moveit::core::JointModelGroup* jmg = robot_model->getJointModelGroup("group");
+
+	auto empty = std::make_shared<PlanningScene>(robot_model);
+	auto blocked = std::make_shared<PlanningScene>(robot_model);
+	// obstacle blocking the arm at +90 degrees
+	blocked->getWorldNonConst()->addToObject("obstacle", std::make_shared<shapes::Box>(0.2, 0.2, 0.2),
+	                                         Eigen::Isometry3d(Eigen::Translation3d(0.0, 0.75, 0.0)));
+	auto scene_at = [jmg](const PlanningScenePtr& scene, double position) {
+		auto result = scene->diff();
+		result->getCurrentStateNonConst().setJointGroupPositions(jmg, std::vector<double>({ position }));
+		result->getCurrentStateNonConst().update();
+		return result;
+	};
+
+	solvers::RoadmapPlanner planner;
+	robot_trajectory::RobotTrajectoryPtr result;
+	ASSERT_TRUE(planner.plan(scene_at(empty, 0.0), scene_at(empty, 0.5), jmg, 1.0, result));
+	EXPECT_EQ(planner.numVertices(), 2u) << "direct edge";
+
+	// further queries reuse the roadmap, only adding their start and goal
+	ASSERT_TRUE(planner.plan(scene_at(empty, 0.2), scene_at(empty, 0.7), jmg, 1.0, result));
+	EXPECT_EQ(planner.numRoadmaps(), 1u);
+	EXPECT_EQ(planner.numVertices(), 4u);
+	ASSERT_TRUE(planner.plan(scene_at(empty, 0.0), scene_at(empty, 0.5), jmg, 1.0, result));
+	EXPECT_EQ(planner.numVertices(), 4u);
+
+	// the direct edge is invalid: start and goal are disconnected and the roadmap grows around the obstacle
+	ASSERT_TRUE(planner.plan(scene_at(blocked, 0.0), scene_at(blocked, 2.0), jmg, 5.0, result));
+	EXPECT_EQ(planner.numRoadmaps(), 2u);
+	const size_t num_vertices = planner.numVertices();
+	EXPECT_GT(num_vertices, 6u);
+	auto collision_free = [&blocked](const robot_trajectory::RobotTrajectory& trajectory) {
+		for (size_t i = 0; i < trajectory.getWayPointCount(); ++i) {
+			moveit::core::RobotState state(trajectory.getWayPoint(i));
+			if (blocked->isStateColliding(state, "group"))
+				return false;
+		}
+		return true;
+	};
+	EXPECT_TRUE(collision_free(*result));
+
+	// the repaired roadmap answers the query again without growing
+	ASSERT_TRUE(planner.plan(scene_at(blocked, 0.0), scene_at(blocked, 2.0), jmg, 5.0, result));
+	EXPECT_EQ(planner.numVertices(), num_vertices);
+	EXPECT_TRUE(collision_free(*result));
+}
+
+// connect a start and goal state differing in two groups, planning them in PARALLEL mode
+static stages::Connect* addParallelConnect(Task& t, const solvers::PlannerInterfacePtr& left,
+                                           const solvers::PlannerInterfacePtr& right) {
+	moveit::core::RobotModelBuilder builder("robot", "base");
+	builder.addChain("base->a->b", "continuous");
+	builder.addChain("base->c->d", "continuous");
+	builder.addGroupChain("base", "b", "left");
+	builder.addGroupChain("base", "d", "right");
+	t.setRobotModel(builder.build());
+
+	auto start = std::make_shared<PlanningScene>(t.getRobotModel());
+	start->getCurrentStateNonConst().setToDefaultValues();
+	auto goal = start->diff();
+	goal->getCurrentStateNonConst().setJointGroupPositions("left", std::vector<double>({ 0.5, 0.5 }));
+	goal->getCurrentStateNonConst().setJointGroupPositions("right", std::vector<double>({ -0.5, 0.2 }));
+	goal->getCurrentStateNonConst().update();
+
+	auto first = new stages::FixedState("start");
+	first->setState(start);
+	auto connect = new stages::Connect("connect", { { "left", left }, { "right", right } });
+	connect->setProperty("merge_mode", stages::Connect::PARALLEL);
+	auto last = new stages::FixedState("goal");
+	last->setState(goal);
+
+	t.add(Stage::pointer(first));
+	t.add(Stage::pointer(connect));
+	t.add(Stage::pointer(last));
+	return connect;
+}
+
+TEST(Connect, parallel) {
+	Task t("parallel");
+	// separate planner instances are planned concurrently
+	auto left = std::make_shared<solvers::JointInterpolationPlanner>();
+	auto right = std::make_shared<solvers::JointInterpolationPlanner>();
+	stages::Connect* connect = addParallelConnect(t, left, right);
+	ASSERT_TRUE(t.plan());
+
+	// both groups planned from the same start and merged into a single trajectory
+	ASSERT_EQ(connect->solutions().size(), 1u);
+	auto solution = dynamic_cast<const SubTrajectory*>(connect->solutions().front().get());
+	ASSERT_TRUE(solution && solution->trajectory());
+	EXPECT_EQ(solution->trajectory()->getGroup()->getVariableCount(), 4u);
+	std::vector<double> positions;
+	solution->trajectory()->getLastWayPoint().copyJointGroupPositions("right", positions);
+	EXPECT_EQ(positions, std::vector<double>({ -0.5, 0.2 }));
+}
+
+// planner instances sharing a (non thread-safe) resource, recording concurrent calls
+class SharedResourcePlanner : public solvers::JointInterpolationPlanner
+{
+	std::atomic<int>& running_;
+	std::atomic<int>& max_running_;
+
+public:
+	SharedResourcePlanner(std::atomic<int>& running, std::atomic<int>& max_running)
+	  : running_(running), max_running_(max_running) {}
+	const void* concurrencyKey() const override { return &running_; }
+
+	using JointInterpolationPlanner::plan;
+	bool plan(const planning_scene::PlanningSceneConstPtr& from, const planning_scene::PlanningSceneConstPtr& to,
+	          const moveit::core::JointModelGroup* jmg, double timeout, robot_trajectory::RobotTrajectoryPtr& result,
+	          const moveit_msgs::Constraints& path_constraints) override {
+		int running = ++running_;
+		max_running_ = std::max<int>(max_running_, running);
+		std::this_thread::sleep_for(std::chrono::milliseconds(20));
+		bool success = JointInterpolationPlanner::plan(from, to, jmg, timeout, result, path_constraints);
+		--running_;
+		return success;
+	}
+};
+
+TEST(Connect, parallelSharedResource) {
+	Task t("parallel");
+	std::atomic<int> running{ 0 }, max_running{ 0 };
+	stages::Connect* connect = addParallelConnect(t, std::make_shared<SharedResourcePlanner>(running, max_running),
+	                                              std::make_shared<SharedResourcePlanner>(running, max_running));
+	ASSERT_TRUE(t.plan());
+	EXPECT_EQ(connect->solutions().size(), 1u);
+	EXPECT_EQ(max_running, 1) << "planners sharing a resource were called concurrently";
+}
+
+TEST(ReachabilityMap, lookup) {
+	// planar arm: tip moves on a circle of radius 0.5 around base, always pointing along +z
+	moveit::core::RobotModelBuilder builder("robot", "base");
+	geometry_msgs::Pose origin, offset;
+	origin.orientation.w = offset.orientation.w = 1.0;
+	offset.position.x = 0.5;
+	builder.addChain("base->a->b", "continuous", { origin, offset }, urdf::Vector3(0, 0, 1));
+	builder.addGroupChain("base", "b", "group");
+	moveit::core::RobotModelConstPtr robot_model = builder.build();
+
+	auto map = ReachabilityMap::compute(robot_model, "group", "b", 0.05, 10000);
+	EXPECT_EQ(map->baseLink(), "base");
+	Eigen::Isometry3d pose = Eigen::Isometry3d::Identity();
+	pose.translation() = Eigen::Vector3d(0.0, 0.5, 0.0);
+	EXPECT_TRUE(map->reachable(pose));
+	EXPECT_FALSE(map->reachable(Eigen::AngleAxisd(M_PI, Eigen::Vector3d::UnitX()) * pose)) << "flipped orientation";
+	EXPECT_FALSE(map->reachable(Eigen::Translation3d(0.5, 0.5, 0.0) * pose)) << "beyond workspace";
+	EXPECT_FALSE(map->reachable(Eigen::Isometry3d::Identity())) << "center of circle";
+
+	// persist and memory-map
+	const std::string filename = tempFile("mtc_reachability_");
+	ASSERT_FALSE(filename.empty());
+	map->save(filename);
+	auto loaded = ReachabilityMap::load(filename);
+	std::remove(filename.c_str());
+	EXPECT_EQ(loaded->group(), "group");
+	EXPECT_EQ(loaded->tip(), "b");
+	EXPECT_TRUE(loaded->reachable(pose));
+	EXPECT_FALSE(loaded->reachable(Eigen::Isometry3d::Identity()));
+	EXPECT_THROW(ReachabilityMap::load(filename), std::runtime_error);
+}
+
+TEST(Connect, multiGoal) {
+	moveit::core::RobotModelBuilder builder("robot", "base");
+	builder.addChain("base->a->b", "continuous");
+	builder.addGroupChain("base", "b", "group");
+
+	for (bool fail_multi_goal : { false, true }) {
+		Task t("multi-goal");
+		t.setRobotModel(builder.build());
+		auto planner = std::make_shared<PipelineMockup>();
+		planner->fail_multi_goal = fail_multi_goal;
+
+		auto start = std::make_shared<PlanningScene>(t.getRobotModel());
+		start->getCurrentStateNonConst().setToDefaultValues();
+		auto first = new stages::FixedState("start");
+		first->setState(start);
+		auto connect = new stages::Connect("connect", { { "group", planner } });
+		connect->setMaxGroupSize(3);
+
+		t.add(Stage::pointer(first));
+		t.add(Stage::pointer(connect));
+		// goals spawned at once, moving the group to the position given as cost
+		auto goals = std::make_unique<SpawningGeneratorMockup>(std::vector<double>{ 0.1, 0.2, 0.3 }, 3, "goals");
+		goals->setSceneModifier([](PlanningScene& scene, double position) {
+			scene.getCurrentStateNonConst().setJointGroupPositions("group", std::vector<double>(2, position));
+			scene.getCurrentStateNonConst().update();
+		});
+		t.add(std::move(goals));
+		ASSERT_TRUE(t.plan());
+
+		if (!fail_multi_goal)  // each request reaches a single goal only: the others are queued again
+			EXPECT_EQ(planner->num_goals, std::vector<size_t>({ 3, 2, 1 }));
+		else  // a failed multi-goal request doesn't fail its goals, but they are planned individually
+			EXPECT_EQ(planner->num_goals, std::vector<size_t>({ 3, 1, 1, 1 }));
+		EXPECT_EQ(connect->solutions().size(), 3u);
+		EXPECT_EQ(connect->failures().size(), 0u);
+		EXPECT_EQ(t.numSolutions(), 3u);
+	}
+}
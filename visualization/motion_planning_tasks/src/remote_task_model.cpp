@@ -72,6 +72,7 @@ struct RemoteTaskModel::Node
 	std::unique_ptr<RemoteSolutionModel> solutions_;
 	std::unique_ptr<rviz::PropertyTreeModel> property_tree_;
 	std::map<std::string, Property> properties_;
+	QString compute_statistics_;  // tooltip summarizing compute time distribution and queue depths
 
 	inline Node(Node* parent) : parent_(parent) {
 		solutions_.reset(new RemoteSolutionModel());
@@ -85,6 +86,7 @@ struct RemoteTaskModel::Node
 		return true;
 	}
 
+	void setStatistics(const moveit_task_constructor_msgs::StageStatistics& s);
 	void setProperties(const std::vector<moveit_task_constructor_msgs::Property>& props,
 	                   const planning_scene::PlanningSceneConstPtr& scene_, rviz::DisplayContext* display_context_);
 	rviz::Property* createProperty(const moveit_task_constructor_msgs::Property& prop, rviz::Property* old,
@@ -92,6 +94,26 @@ struct RemoteTaskModel::Node
 	                               rviz::DisplayContext* display_context_);
 };
 
+void RemoteTaskModel::Node::setStatistics(const moveit_task_constructor_msgs::StageStatistics& s) {
+	solutions_->processSolutionIDs(s.solved, s.failed, s.num_failed, s.total_compute_time);
+
+	const QLocale locale;
+	auto ms = [&locale](double seconds) { return locale.toString(1000.0 * seconds, 'f', 2); };
+	compute_statistics_ = QString("compute calls: %1\n"
+	                              "time per call [ms]: p50 %2, p90 %3, p99 %4, max %5\n"
+	                              "max. pending states: %6 start, %7 end")
+	                          .arg(s.num_computes)
+	                          .arg(ms(s.compute_time_p50), ms(s.compute_time_p90), ms(s.compute_time_p99),
+	                               ms(s.compute_time_max))
+	                          .arg(s.max_pending_starts)
+	                          .arg(s.max_pending_ends);
+
+	auto kib = [&locale](uint64_t bytes) { return locale.toString(bytes / 1024.0, 'f', 1); };
+	compute_statistics_ += QString("\nmemory [KiB]: states %1, scenes %2, trajectories %3, markers %4")
+	                           .arg(kib(s.memory_states), kib(s.memory_scenes), kib(s.memory_trajectories),
+	                                kib(s.memory_markers));
+}
+
 void RemoteTaskModel::Node::setProperties(const std::vector<moveit_task_constructor_msgs::Property>& props,
                                           const planning_scene::PlanningSceneConstPtr& scene_,
                                           rviz::DisplayContext* display_context_) {
@@ -258,6 +280,10 @@ QVariant RemoteTaskModel::data(const QModelIndex& index, int role) const {
 					return QLocale().toString(n->solutions_->totalComputeTime(), 'f', 4);
 			}
 			break;
+		case Qt::ToolTipRole:
+			if (index.column() > 0)
+				return n->compute_statistics_;
+			break;
 		case Qt::ForegroundRole:
 			if (index.column() == 0 && !index.parent().isValid())
 				return (flags_ & IS_DESTROYED) ? QColor(Qt::red) : QApplication::palette().text().color();
@@ -355,7 +381,7 @@ void RemoteTaskModel::processStageStatistics(const moveit_task_constructor_msgs:
 			continue;
 		}
 		Node* n = it->second;
-		n->solutions_->processSolutionIDs(s.solved, s.failed, s.num_failed, s.total_compute_time);
+		n->setStatistics(s);
 
 		// emit notify about model changes when node was already visited
 		if (n->node_flags_ & WAS_VISITED) {